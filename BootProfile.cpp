@@ -0,0 +1,69 @@
+#include "BootProfile.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include "ThingsBoardMQTT.h"
+
+BootProfile Boot;
+
+static const char* const PHASE_KEYS[] = {
+    "boot_relays_ms",
+    "boot_setup_ms",
+    "boot_wifi_ms",
+    "boot_mqtt_ms"
+};
+
+static_assert(sizeof(PHASE_KEYS) / sizeof(PHASE_KEYS[0]) == (size_t)BootPhase::COUNT, "PHASE_KEYS must match BootPhase");
+
+static const char* resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "power_on";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT:       return "watchdog";
+        case ESP_RST_DEEPSLEEP: return "deep_sleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        default:                return "unknown";
+    }
+}
+
+BootProfile::BootProfile() {
+    memset(_phaseMs, 0, sizeof(_phaseMs));
+    _marked = 0;
+    _reported = false;
+}
+
+void BootProfile::mark(BootPhase phase) {
+    uint8_t bit = 1 << (uint8_t)phase;
+    if (_marked & bit) return;
+    
+    _phaseMs[(size_t)phase] = esp_timer_get_time() / 1000;
+    _marked |= bit;
+    DEBUG_PRINTF("[Boot] %s: %u ms\n", PHASE_KEYS[(size_t)phase], _phaseMs[(size_t)phase]);
+}
+
+void BootProfile::loop() {
+    if (_reported || !(_marked & (1 << (uint8_t)BootPhase::MQTT_UP))) return;
+    if (!TB.outboxIdle()) return;
+    
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    writeReport(json);
+    json.endObject();
+    
+    _reported = TB.publish(TB_ATTRIBUTES_TOPIC, json);
+}
+
+// {"boot_relays_ms":4,"boot_setup_ms":95,"boot_wifi_ms":780,"boot_mqtt_ms":960,"fast_boot":true,"reset_reason":"software"}
+void BootProfile::writeReport(JsonWriter& json) {
+    for (size_t i = 0; i < (size_t)BootPhase::COUNT; i++) {
+        if (_marked & (1 << i)) {
+            json.add(PHASE_KEYS[i], (unsigned long)_phaseMs[i]);
+        }
+    }
+    json.add("fast_boot", (bool)FAST_BOOT);
+    json.add("reset_reason", resetReasonName(esp_reset_reason()));
+}
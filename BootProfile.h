@@ -0,0 +1,35 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "JsonWriter.h"
+
+// Açılış aşamalarının zamanı (esp_timer, uygulama başlangıcından ms).
+// İlk bağlantıda bir kez "boot_*" attribute'ları olarak gönderilir.
+enum class BootPhase : uint8_t {
+    RELAYS_RESTORED,    // Röle çıkışları son / varsayılan durumda
+    SETUP_DONE,         // Tüm modüller başlatıldı
+    WIFI_UP,            // IP alındı
+    MQTT_UP,            // ThingsBoard'a bağlanıldı (SUBACK)
+    COUNT
+};
+
+class BootProfile {
+public:
+    BootProfile();
+    
+    void mark(BootPhase phase);     // Yalnızca ilk işaret saklanır
+    
+    void loop();    // Ağ task'ı (bağlıyken)
+    void writeReport(JsonWriter& json);
+
+private:
+    uint32_t _phaseMs[(size_t)BootPhase::COUNT];
+    uint8_t _marked;
+    bool _reported;
+};
+
+extern BootProfile Boot;
+
+#endif // BOOT_PROFILE_H
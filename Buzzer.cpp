@@ -2,8 +2,25 @@
 
 Buzzer Buzz;
 
+static_assert((BUZZER_QUEUE_SIZE & (BUZZER_QUEUE_SIZE - 1)) == 0, "BUZZER_QUEUE_SIZE must be a power of two");
+
+// Desenler (frekans Hz, süre ms)
+static const BuzzerStep DOUBLE_STEPS[] = { {2000, 50}, {0, 50}, {2000, 50} };
+static const BuzzerStep TRIPLE_STEPS[] = { {2000, 50}, {0, 50}, {2000, 50}, {0, 50}, {2000, 50} };
+static const BuzzerStep BOOT_STEPS[] = { {1000, 100}, {0, 50}, {1500, 100}, {0, 50}, {2000, 150} };    // Artan ton
+static const BuzzerStep SUCCESS_STEPS[] = { {1500, 100}, {0, 50}, {2500, 150} };                       // İki yükselen ton
+static const BuzzerStep ERROR_STEPS[] = { {500, 300}, {0, 100}, {500, 300} };                          // Düşük ton, uzun
+static const BuzzerStep CLICK_STEPS[] = { {3000, 10} };
+
+#define STEP_COUNT(steps) (sizeof(steps) / sizeof(steps[0]))
+
 Buzzer::Buzzer() {
     _muted = false;
+    _head = 0;
+    _tail = 0;
+    _lastPattern = BuzzerPattern::NONE;
+    _active = false;
+    _timer = nullptr;
 }
 
 void Buzzer::begin() {
@@ -13,6 +30,17 @@ void Buzzer::begin() {
     ledcAttach(GPIO_BUZZER, 2000, 8);
     ledcWrite(GPIO_BUZZER, 0);
     
+    esp_timer_create_args_t args = {};
+    args.callback = timerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "buzzer";
+    if (esp_timer_create(&args, &_timer) != ESP_OK) {
+        DEBUG_PRINTLN("[Buzzer] Failed to create timer, sounds disabled");
+        _timer = nullptr;
+        return;
+    }
+    
     DEBUG_PRINTLN("[Buzzer] Ready");
 }
 
@@ -21,66 +49,51 @@ void Buzzer::beep(uint16_t durationMs) {
 }
 
 void Buzzer::beep(uint16_t frequency, uint16_t durationMs) {
-    if (_muted) return;
-    
-    tone(frequency, durationMs);
+    BuzzerStep step = { frequency, durationMs };
+    play(BuzzerPattern::BEEP, &step, 1);
 }
 
 void Buzzer::doubleBeep() {
-    if (_muted) return;
-    
-    beep(2000, 50);
-    delay(50);
-    beep(2000, 50);
+    play(BuzzerPattern::DOUBLE_BEEP, DOUBLE_STEPS, STEP_COUNT(DOUBLE_STEPS));
 }
 
 void Buzzer::tripleBeep() {
-    if (_muted) return;
-    
-    beep(2000, 50);
-    delay(50);
-    beep(2000, 50);
-    delay(50);
-    beep(2000, 50);
+    play(BuzzerPattern::TRIPLE_BEEP, TRIPLE_STEPS, STEP_COUNT(TRIPLE_STEPS));
 }
 
 void Buzzer::bootSound() {
-    if (_muted) return;
-    
-    // Artan ton - açılış
-    beep(1000, 100);
-    delay(50);
-    beep(1500, 100);
-    delay(50);
-    beep(2000, 150);
+    play(BuzzerPattern::BOOT, BOOT_STEPS, STEP_COUNT(BOOT_STEPS));
 }
 
 void Buzzer::successSound() {
-    if (_muted) return;
-    
-    // İki yükselen ton
-    beep(1500, 100);
-    delay(50);
-    beep(2500, 150);
+    play(BuzzerPattern::SUCCESS, SUCCESS_STEPS, STEP_COUNT(SUCCESS_STEPS));
 }
 
 void Buzzer::errorSound() {
-    if (_muted) return;
-    
-    // Düşük ton, uzun
-    beep(500, 300);
-    delay(100);
-    beep(500, 300);
+    play(BuzzerPattern::ERROR, ERROR_STEPS, STEP_COUNT(ERROR_STEPS));
 }
 
 void Buzzer::clickSound() {
-    if (_muted) return;
-    
-    beep(3000, 10);
+    // Toplu röle komutu: tek tur içindeki değişiklikler tek tık olarak duyulur
+    play(BuzzerPattern::CLICK, CLICK_STEPS, STEP_COUNT(CLICK_STEPS));
+}
+
+void Buzzer::stop() {
+    portENTER_CRITICAL(&_mux);
+    _head = _tail;
+    _lastPattern = BuzzerPattern::NONE;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool Buzzer::isPlaying() {
+    return _active;
 }
 
 void Buzzer::setMuted(bool muted) {
     _muted = muted;
+    if (muted) {
+        stop();
+    }
     DEBUG_PRINTF("[Buzzer] Muted: %s\n", muted ? "yes" : "no");
 }
 
@@ -88,12 +101,60 @@ bool Buzzer::isMuted() {
     return _muted;
 }
 
-void Buzzer::tone(uint16_t frequency, uint16_t durationMs) {
-    ledcWriteTone(GPIO_BUZZER, frequency);
-    delay(durationMs);
-    noTone();
+void Buzzer::play(BuzzerPattern pattern, const BuzzerStep* steps, size_t count) {
+    if (_muted || _timer == nullptr) return;
+    
+    bool start = false;
+    
+    portENTER_CRITICAL(&_mux);
+    // Aynı desen hâlâ kuyrukta / çalıyorsa birleştir (serbest beep hariç); yer yoksa desenin tamamı atlanır
+    bool duplicate = pattern != BuzzerPattern::BEEP && pattern == _lastPattern;
+    if (!duplicate && BUZZER_QUEUE_SIZE - (_tail - _head) >= count) {
+        for (size_t i = 0; i < count; i++) {
+            QueuedStep& slot = _steps[_tail & (BUZZER_QUEUE_SIZE - 1)];
+            slot.step = steps[i];
+            slot.pattern = pattern;
+            _tail++;
+        }
+        _lastPattern = pattern;
+        if (!_active) {
+            _active = true;
+            start = true;
+        }
+    }
+    portEXIT_CRITICAL(&_mux);
+    
+    // Zamanlayıcı boştaydı: ilk adım da esp_timer task'ında başlar (LEDC'nin tek yazarı)
+    if (start) {
+        esp_timer_start_once(_timer, 0);
+    }
+}
+
+// Yalnızca esp_timer task'ından - callback'ler sırayla çalışır
+void Buzzer::advance() {
+    QueuedStep next;
+    bool hasNext = false;
+    
+    portENTER_CRITICAL(&_mux);
+    if (_head != _tail) {
+        next = _steps[_head & (BUZZER_QUEUE_SIZE - 1)];
+        _head++;
+        hasNext = true;
+    } else {
+        _active = false;
+        _lastPattern = BuzzerPattern::NONE;
+    }
+    portEXIT_CRITICAL(&_mux);
+    
+    if (!hasNext) {
+        ledcWriteTone(GPIO_BUZZER, 0);
+        return;
+    }
+    
+    ledcWriteTone(GPIO_BUZZER, next.step.frequency);
+    esp_timer_start_once(_timer, (uint64_t)max(next.step.durationMs, (uint16_t)1) * 1000);
 }
 
-void Buzzer::noTone() {
-    ledcWriteTone(GPIO_BUZZER, 0);
+void Buzzer::timerCallback(void* arg) {
+    static_cast<Buzzer*>(arg)->advance();
 }
@@ -2,8 +2,31 @@
 #define BUZZER_H
 
 #include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
 #include "Config.h"
 
+// Nota adımı: frekans 0 = sessizlik
+struct BuzzerStep {
+    uint16_t frequency;
+    uint16_t durationMs;
+};
+
+// Ses desenleri - aynı desen bitmeden tekrar istenirse birleştirilir (tek kez çalar)
+enum class BuzzerPattern : uint8_t {
+    NONE,
+    BEEP,
+    DOUBLE_BEEP,
+    TRIPLE_BEEP,
+    BOOT,
+    SUCCESS,
+    ERROR,
+    CLICK
+};
+
+// Bloklamayan nota sıralayıcı: desenler adım kuyruğuna eklenir,
+// adımlar esp_timer callback'inden (LEDC tonu) sırayla çalınır - LEDC'ye yalnızca o yazar.
+// Her task'tan çağrılabilir (ISR hariç); çağıran hiç beklemez.
 class Buzzer {
 public:
     Buzzer();
@@ -22,15 +45,33 @@ public:
     void errorSound();
     void clickSound();
     
+    void stop();            // Kuyruğu boşalt, çalan adım bitince susar
+    bool isPlaying();
+    
     // Sessiz mod
     void setMuted(bool muted);
     bool isMuted();
 
 private:
+    struct QueuedStep {
+        BuzzerStep step;
+        BuzzerPattern pattern;
+    };
+    
     bool _muted;
     
-    void tone(uint16_t frequency, uint16_t durationMs);
-    void noTone();
+    QueuedStep _steps[BUZZER_QUEUE_SIZE];
+    size_t _head;
+    size_t _tail;
+    BuzzerPattern _lastPattern;     // Son eklenen desen, sıralayıcı boşalınca NONE
+    bool _active;                   // Bir adım çalıyor (zamanlayıcı kurulu)
+    esp_timer_handle_t _timer;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    
+    void play(BuzzerPattern pattern, const BuzzerStep* steps, size_t count);
+    void advance();
+    
+    static void timerCallback(void* arg);
 };
 
 extern Buzzer Buzz;
@@ -23,6 +23,7 @@
 
 #define GPIO_RS485_TX   17
 #define GPIO_RS485_RX   18
+#define GPIO_RS485_DE   -1      // Yön kontrolü: kartta otomatik (-1), harici DE pini varsa GPIO no
 
 #define GPIO_I2C_SDA    4
 #define GPIO_I2C_SCL    5
@@ -31,6 +32,12 @@
 #define RELAY_COUNT     6
 #define RELAY_ON        HIGH
 #define RELAY_OFF       LOW
+#define RELAY_ALL_MASK  ((1 << RELAY_COUNT) - 1)
+
+// --- Relay State Journal ---
+#define RELAY_RESTORE_ON_BOOT       false   // true: son durumlar açılışta (WiFi'dan önce) geri yüklenir
+#define RELAY_JOURNAL_SETTLE_MS     1000    // Son değişiklikten sonra yazma (hızlı anahtarlama tek yazma)
+#define RELAY_JOURNAL_MAX_DELAY_MS  5000    // Sürekli değişimde en geç yazma
 
 // --- WiFi AP Mode (Configuration) ---
 #define AP_SSID         "ESP32-Relay-Setup"
@@ -39,17 +46,157 @@
 
 // --- ThingsBoard Defaults ---
 #define TB_PORT_DEFAULT 1883
+#define TB_PORT_TLS_DEFAULT 8883
+#define TB_CA_CERT_MAX_LEN  4000    // PEM, NVS string sınırı içinde
 #define TB_TELEMETRY_TOPIC    "v1/devices/me/telemetry"
 #define TB_ATTRIBUTES_TOPIC   "v1/devices/me/attributes"
 #define TB_RPC_REQUEST_TOPIC  "v1/devices/me/rpc/request/+"
+#define TB_RPC_REQUEST_PREFIX "v1/devices/me/rpc/request/"
 #define TB_RPC_RESPONSE_TOPIC "v1/devices/me/rpc/response/"
+#define TB_ATTR_REQUEST_TOPIC   "v1/devices/me/attributes/request/"
+#define TB_ATTR_RESPONSE_TOPIC  "v1/devices/me/attributes/response/+"
+#define TB_ATTR_RESPONSE_PREFIX "v1/devices/me/attributes/response/"
+#define TB_GATEWAY_TELEMETRY_TOPIC "v1/gateway/telemetry"
+
+// --- MQTT Session ---
+// Kalıcı oturum + QoS 1: kısa kesintide gelen RPC / attribute güncellemeleri
+// broker'da bekletilir ve yeniden bağlanınca teslim edilir (client ID sabit: MAC)
+#define MQTT_CLEAN_SESSION      false
+#define MQTT_SUBSCRIBE_QOS      1
+
+// --- Payload Buffers ---
+#define JSON_BUFFER_SIZE        256     // Stack üzerindeki JSON payload tamponu
+#define MQTT_BUFFER_SIZE        512     // PubSubClient tamponu: gelen mesajlar ve küçük publish'ler
+#define MQTT_STREAM_CHUNK_SIZE  128     // publishStream: büyük mesajlar bu parçalarla sokete yazılır
+#define MQTT_TLS_TX_PENDING     1024    // TLS: soket doluyken kabul edilip sonra gönderilen bayt (aşarsa bağlantı kapanır)
+#define PROTO_TRANSCODE_CAPACITY 512    // Protobuf modu: düz JSON -> protobuf çevirisi için düğüm havuzu
+
+// --- Outbound Queue ---
+// Küçük mesajlar (RPC yanıtı, röle telemetry'si, attribute) öncelik kuyruğundan
+// loop()'ta gönderilir; büyük toplu mesajlar (backlog, gateway, sensör) kuyruk boşken
+#define PUBLISH_QUEUE_DEPTH     4       // Öncelik başına mesaj
+#define PUBLISH_PAYLOAD_MAX     JSON_BUFFER_SIZE
+#define PUBLISH_TOPIC_MAX       48
+#define PUBLISH_TICK_BYTES      1024    // loop() başına gönderilecek en fazla bayt
+
+// --- RPC ---
+#define RPC_MAX_METHODS         32      // Kayıtlı RPC metodu üst sınırı (2'nin kuvveti)
+#define RPC_RESTART_DELAY_MS    500     // reboot/resetConfig yanıtı gittikten sonra
+#define RX_JSON_CAPACITY        256     // Gelen RPC/attribute mesajı için ArduinoJson düğüm havuzu (string'ler kopyalanmaz)
+#define RPC_REQUEST_ID_MAX_LEN  10      // requestId hane sayısı üst sınırı
+
+// --- Attribute Publishing ---
+// Statik attribute'lar (firmware, device_type, mac, ip) bağlantı başına bir kez,
+// dinamikler (rssi, free_heap, uptime) eşik aşılınca veya max-age dolunca
+#define ATTR_CHECK_INTERVAL_MS  5000    // Dinamik attribute kontrol periyodu
+#define ATTR_MAX_AGE_MS         600000  // Değişmese de en geç 10 dakikada bir
+#define ATTR_RSSI_DELTA_DBM     5       // RSSI değişim eşiği
+#define ATTR_HEAP_DELTA_BYTES   8192    // free_heap değişim eşiği
+
+// --- Offline Telemetry Queue ---
+#define TELEMETRY_QUEUE_CAPACITY        4096    // PSRAM halka tamponu (olay, 16 bayt/olay)
+#define TELEMETRY_QUEUE_CAPACITY_NOPSRAM 256    // PSRAM yoksa dahili RAM
+#define TELEMETRY_SPILL_PARTITION       "tbqueue" // Yoksa flash taşma devre dışı
+#define TELEMETRY_SPILL_BATCH           64      // RAM dolunca flash'a taşınan olay sayısı
+#define TELEMETRY_BATCH_MAX_EVENTS      64      // Bir batch mesajındaki en fazla olay (akışla gönderilir)
+#define TELEMETRY_DRAIN_INTERVAL_MS     100     // Batch mesajları arası süre
+
+// --- RS485 / Modbus RTU ---
+// Aynı hatta yalnızca bir rol: master (sayaç okuma, gateway), slave (PLC röle kontrolü) veya kapalı
+#define MODBUS_MODE_OFF             0
+#define MODBUS_MODE_MASTER          1
+#define MODBUS_MODE_SLAVE           2
+#define MODBUS_MODE                 MODBUS_MODE_OFF
+#define MODBUS_SLAVE_ID             1       // Slave modunda bu cihazın adresi
+#define MODBUS_UART_NUM             1
+#define MODBUS_BAUD                 9600
+#define MODBUS_PARITY_EVEN          false   // false: 8N1, true: 8E1
+#define MODBUS_UART_BUFFER          256
+#define MODBUS_RX_TIMEOUT_SYMBOLS   4       // Çerçeve sonu: ~3.5 karakter sessizlik (donanım)
+#define MODBUS_FRAME_GAP_BITS       39      // Çerçeveler arası en az 3.5 karakter (11 bit/karakter)
+#define MODBUS_RESPONSE_TIMEOUT_MS  300
+#define MODBUS_POLL_INTERVAL_MS     5000    // Poll çevrimi (bir gateway mesajı / çevrim)
+#define MODBUS_MAX_POINTS           32      // Poll tablosu (en fazla 32)
+#define MODBUS_MAX_BLOCK_REGS       32      // Birleştirilmiş tek istekte en fazla register
+#define MODBUS_MAX_GAP_REGS         4       // Birleştirirken atlanabilecek boş register
+#define MODBUS_TASK_CORE            1
+#define MODBUS_TASK_PRIORITY        10      // Röle task'ının altında
+#define MODBUS_TASK_STACK           4096
+#define MODBUS_SLAVE_TASK_PRIORITY  18      // Slave: ağdan bağımsız düşük gecikme, röle task'ının hemen altında
+
+// --- I2C Sensors ---
+// Örnekler cihazda toplanır; her pencere sonunda tek telemetry mesajı (min/max/mean/son)
+#define SENSOR_ENABLED              false
+#define SENSOR_I2C_FREQ             100000
+#define SENSOR_SAMPLE_INTERVAL_MS   1000
+#define SENSOR_WINDOW_MS            TELEMETRY_INTERVAL_MS
+#define SENSOR_MAX_SENSORS          8
+#define SENSOR_MAX_CHANNELS         16      // Tüm sensörlerin toplam değer sayısı
+#define SENSOR_TASK_CORE            1
+#define SENSOR_TASK_PRIORITY        5
+#define SENSOR_TASK_STACK           4096
+
+// --- Time (SNTP) ---
+#define NTP_SERVER_1    "pool.ntp.org"
+#define NTP_SERVER_2    "time.google.com"
+#define LOCAL_TIMEZONE  "<+03>-3"   // POSIX TZ: zamanlama kuralları yerel saatle (Türkiye, UTC+3)
+
+// --- Scheduler ---
+#define SCHEDULE_MAX_RULES          16
+#define SCHEDULE_CRON_MAX_LEN       40      // Cron ifadesi (sonlandırıcı dahil)
+#define SCHEDULE_MAX_SLEEP_MS       60000   // SNTP düzeltmelerini yakalamak için en uzun uyku
+#define SCHEDULE_RUN_QUEUE_SIZE     8       // Gönderilmeyi bekleyen çalışma kayıtları (2'nin kuvveti)
+#define SCHEDULE_TASK_CORE          1
+#define SCHEDULE_TASK_PRIORITY      8
+#define SCHEDULE_TASK_STACK         4096
+
+// --- Buzzer ---
+#define BUZZER_QUEUE_SIZE           16      // Bekleyen nota adımları (2'nin kuvveti), dolunca yeni desen atlanır
+
+// --- Performance Stats ---
+// Ağ task'ı tur süresi / gecikmesi ve handler süreleri (getPerfStats RPC)
+#define PERF_ENABLED                true
+#define PERF_BUCKETS                24      // log2 µs kovaları, son kova >= 8.4 s
+#define PERF_TELEMETRY_INTERVAL_MS  0       // 0: yalnızca RPC ile; örn. 300000 = 5 dakikada bir telemetry
 
 // --- Timing Configuration ---
 #define TELEMETRY_INTERVAL_MS   30000   // 30 saniye
+#define TELEMETRY_COALESCE_MS   250     // Röle değişiklikleri için maksimum birleştirme penceresi
 #define HEARTBEAT_INTERVAL_MS   60000   // 1 dakika
-#define MQTT_RECONNECT_DELAY_MS 5000    // 5 saniye
+#define MQTT_BACKOFF_MIN_MS     1000    // İlk yeniden deneme (1 saniye)
+#define MQTT_BACKOFF_MAX_MS     60000   // Üstel backoff tavanı (1 dakika)
+#define MQTT_STEP_TIMEOUT_MS    5000    // DNS/TCP/CONNACK/SUBACK adım zaman aşımı
+#define MQTT_TLS_TIMEOUT_MS     15000   // Tam TLS handshake (RSA/ECDHE S3'te saniyeler sürebilir)
 #define WIFI_RECONNECT_DELAY_MS 10000   // 10 saniye
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000   // Önbellekli (BSSID + kanal) deneme, sonra tam tarama
+#define WIFI_CACHE_STATIC_IP    true    // Önbellekteki IP statik kullanılır (router'da DHCP rezervasyonu önerilir)
+#define WIFI_GATEWAY_PROBE_MS   500     // Statik önbellek IP'si: ağ geçidine ARP isteği aralığı
+#define WIFI_GATEWAY_PROBE_TRIES 4      // Yanıt gelmezse IP eskimiş sayılır, DHCP ile yeniden bağlanılır
 #define WATCHDOG_TIMEOUT_S      30      // 30 saniye
+#define FAST_BOOT               true    // Seri port beklemesi yok, WiFi modüllerle paralel
+
+// --- Tasks ---
+// Ağ (WiFi, portal, MQTT, OTA, LED) core 0'da; röle task'ı core 1'de yüksek öncelikle
+#define NETWORK_TASK_CORE           0
+#define NETWORK_TASK_PRIORITY       1
+#define NETWORK_TASK_STACK          8192
+#define RELAY_TASK_CORE             1
+#define RELAY_TASK_PRIORITY         20      // configMAX_PRIORITIES (25) altında, ağ task'larının üstünde
+#define RELAY_TASK_STACK            4096
+#define RELAY_COMMAND_QUEUE_SIZE    16      // Kaynak başına (2'nin kuvveti)
+#define RELAY_EVENT_QUEUE_SIZE      32      // Durum değişikliği olayları (2'nin kuvveti)
+#define RELAY_TIMER_EVENT_QUEUE_SIZE 8      // Süre dolumu olayları (2'nin kuvveti)
+#define RELAY_TIMER_MAX_MS          86400000UL  // Pulse / süreli mod üst sınırı (24 saat)
+
+// --- Event Loop / Power ---
+// Ağ task'ı olay ve en yakın zamana kadar uyur; röle task'ı bundan etkilenmez
+#define LOOP_MAX_IDLE_MS        1000    // En uzun uyku (OTA ve MQTT keepalive yoklaması)
+#define LOOP_POLL_MS            10      // Bağlantı kurulurken / portal açıkken yoklama aralığı
+#define POWER_SAVE_ENABLED      true    // DFS (CONFIG_PM_ENABLE gerekir)
+#define POWER_CPU_MAX_MHZ       240
+#define POWER_CPU_MIN_MHZ       80      // APB 80 MHz'de kalır - UART / I2C baud etkilenmez
+#define POWER_LIGHT_SLEEP       false   // Otomatik light sleep (tickless idle gerekir, RS485 ile kullanmayın)
+#define POWER_WIFI_MODEM_SLEEP  false   // true: daha az akım, ama röle komutları DTIM aralığı kadar (~100-300 ms) geç gelir
 
 // --- NVS Keys ---
 #define NVS_NAMESPACE       "relay_config"
@@ -58,6 +205,13 @@
 #define NVS_KEY_TB_SERVER   "tb_server"
 #define NVS_KEY_TB_PORT     "tb_port"
 #define NVS_KEY_TB_TOKEN    "tb_token"
+#define NVS_KEY_TB_TLS      "tb_tls"
+#define NVS_KEY_TB_CA       "tb_ca"
+#define NVS_KEY_TB_PROTO    "tb_proto"
+#define NVS_KEY_SCHEDULE    "schedule"
+#define NVS_KEY_RELAYS      "relays"
+#define NVS_KEY_WIFI_CACHE  "wifi_cache"
+#define NVS_KEY_DESIRED     "desired"
 #define NVS_KEY_CONFIGURED  "configured"
 
 // --- LED Status Colors (RGB) ---
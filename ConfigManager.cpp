@@ -28,6 +28,8 @@ bool ConfigManager::loadConfig() {
         String server = _prefs.getString(NVS_KEY_TB_SERVER, "");
         String token = _prefs.getString(NVS_KEY_TB_TOKEN, "");
         _config.tbPort = _prefs.getUShort(NVS_KEY_TB_PORT, TB_PORT_DEFAULT);
+        _config.tbTls = _prefs.getBool(NVS_KEY_TB_TLS, false);
+        _config.tbProto = _prefs.getBool(NVS_KEY_TB_PROTO, false);
         
         strncpy(_config.wifiSsid, ssid.c_str(), sizeof(_config.wifiSsid) - 1);
         strncpy(_config.wifiPassword, pass.c_str(), sizeof(_config.wifiPassword) - 1);
@@ -53,7 +55,11 @@ bool ConfigManager::saveConfig() {
     _prefs.putString(NVS_KEY_TB_SERVER, _config.tbServer);
     _prefs.putUShort(NVS_KEY_TB_PORT, _config.tbPort);
     _prefs.putString(NVS_KEY_TB_TOKEN, _config.tbToken);
+    _prefs.putBool(NVS_KEY_TB_TLS, _config.tbTls);
+    _prefs.putBool(NVS_KEY_TB_PROTO, _config.tbProto);
     _prefs.putBool(NVS_KEY_CONFIGURED, true);
+    _prefs.remove(NVS_KEY_WIFI_CACHE);     // Ağ değişmiş olabilir
+    _prefs.remove(NVS_KEY_DESIRED);        // Cihaz (token) değişmiş olabilir
     
     _config.configured = true;
     
@@ -77,6 +83,72 @@ void ConfigManager::resetConfig() {
     DEBUG_PRINTLN("[Config] Reset complete");
 }
 
+bool ConfigManager::loadWiFiCache(WiFiCache& cache) {
+    _prefs.begin(NVS_NAMESPACE, true);
+    bool ok = _prefs.getBytesLength(NVS_KEY_WIFI_CACHE) == sizeof(WiFiCache) &&
+              _prefs.getBytes(NVS_KEY_WIFI_CACHE, &cache, sizeof(WiFiCache)) == sizeof(WiFiCache);
+    _prefs.end();
+    
+    return ok && cache.channel != 0 && cache.ip != 0;
+}
+
+void ConfigManager::saveWiFiCache(const WiFiCache& cache) {
+    _prefs.begin(NVS_NAMESPACE, false);
+    _prefs.putBytes(NVS_KEY_WIFI_CACHE, &cache, sizeof(WiFiCache));
+    _prefs.end();
+}
+
+void ConfigManager::clearWiFiCache() {
+    _prefs.begin(NVS_NAMESPACE, false);
+    _prefs.remove(NVS_KEY_WIFI_CACHE);
+    _prefs.end();
+}
+
+uint16_t ConfigManager::loadDesiredRelays() {
+    _prefs.begin(NVS_NAMESPACE, true);
+    uint16_t desired = _prefs.getUShort(NVS_KEY_DESIRED, 0);
+    _prefs.end();
+    return desired;
+}
+
+void ConfigManager::saveDesiredRelays(uint16_t desired) {
+    _prefs.begin(NVS_NAMESPACE, false);
+    _prefs.putUShort(NVS_KEY_DESIRED, desired);
+    _prefs.end();
+}
+
+size_t ConfigManager::loadCaCert(char* buf, size_t size) {
+    if (size == 0) return 0;
+    buf[0] = '\0';
+    
+    _prefs.begin(NVS_NAMESPACE, true);
+    size_t len = _prefs.isKey(NVS_KEY_TB_CA) ? _prefs.getString(NVS_KEY_TB_CA, buf, size) : 0;
+    _prefs.end();
+    
+    return len > 0 ? strlen(buf) : 0;
+}
+
+bool ConfigManager::saveCaCert(const char* pem) {
+    size_t len = strlen(pem);
+    if (len >= TB_CA_CERT_MAX_LEN) {
+        DEBUG_PRINTF("[Config] CA certificate too large (%u bytes)\n", len);
+        return false;
+    }
+    
+    _prefs.begin(NVS_NAMESPACE, false);
+    bool ok;
+    if (len == 0) {
+        _prefs.remove(NVS_KEY_TB_CA);
+        ok = true;
+    } else {
+        ok = _prefs.putString(NVS_KEY_TB_CA, pem) == len;
+    }
+    _prefs.end();
+    
+    DEBUG_PRINTF("[Config] CA certificate %s\n", len == 0 ? "cleared" : (ok ? "saved" : "save failed"));
+    return ok;
+}
+
 void ConfigManager::startAPMode() {
     DEBUG_PRINTLN("[Config] Starting AP Mode...");
     
@@ -170,11 +242,19 @@ void ConfigManager::handleSave() {
         strncpy(_config.wifiSsid, _server->arg("wifi_ssid").c_str(), sizeof(_config.wifiSsid) - 1);
         strncpy(_config.wifiPassword, _server->arg("wifi_pass").c_str(), sizeof(_config.wifiPassword) - 1);
         strncpy(_config.tbServer, _server->arg("tb_server").c_str(), sizeof(_config.tbServer) - 1);
+        _config.tbTls = _server->hasArg("tb_tls");
+        _config.tbProto = _server->hasArg("tb_proto");
         _config.tbPort = _server->arg("tb_port").toInt();
-        if (_config.tbPort == 0) _config.tbPort = TB_PORT_DEFAULT;
+        if (_config.tbPort == 0) _config.tbPort = _config.tbTls ? TB_PORT_TLS_DEFAULT : TB_PORT_DEFAULT;
         strncpy(_config.tbToken, _server->arg("tb_token").c_str(), sizeof(_config.tbToken) - 1);
         
         saveConfig();
+        // Boş bırakılırsa kayıtlı sertifika korunur; "sil" ile yerleşik CA paketine dönülür
+        if (_server->hasArg("tb_ca_clear")) {
+            saveCaCert("");
+        } else if (_server->arg("tb_ca").length() > 0) {
+            saveCaCert(_server->arg("tb_ca").c_str());
+        }
         
         String response = R"(
 <!DOCTYPE html><html><head><meta charset="UTF-8">
@@ -201,7 +281,10 @@ void ConfigManager::handleSave() {
 }
 
 void ConfigManager::handleStatus() {
-    _server->send(200, "application/json", generateStatusJSON());
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    generateStatusJSON(json);
+    _server->send_P(200, "application/json", json.c_str(), json.length());
 }
 
 void ConfigManager::handleReset() {
@@ -268,7 +351,7 @@ String ConfigManager::generateHTML() {
             margin-bottom: 6px;
             font-size: 14px;
         }
-        input {
+        input, textarea {
             width: 100%;
             padding: 12px;
             border: 2px solid #1a1a2e;
@@ -279,7 +362,22 @@ String ConfigManager::generateHTML() {
             margin-bottom: 15px;
             transition: border-color 0.3s;
         }
-        input:focus {
+        textarea {
+            height: 90px;
+            font-family: monospace;
+            font-size: 11px;
+            resize: vertical;
+        }
+        .check {
+            display: flex;
+            align-items: center;
+            gap: 8px;
+        }
+        .check input {
+            width: auto;
+            margin: 0 0 15px 0;
+        }
+        input:focus, textarea:focus {
             outline: none;
             border-color: #e94560;
         }
@@ -382,6 +480,21 @@ String ConfigManager::generateHTML() {
                        value=")rawhtml";
     html += _config.tbToken;
     html += R"rawhtml(">
+                <label class="check">
+                    <input type="checkbox" name="tb_tls" value="1")rawhtml";
+    html += _config.tbTls ? " checked" : "";
+    html += R"rawhtml(> TLS (MQTTS, port 8883)
+                </label>
+                <label>CA Sertifikasi (PEM, opsiyonel - yoksa yerlesik CA paketi)</label>
+                <textarea name="tb_ca" placeholder="-----BEGIN CERTIFICATE----- (bos birakilirsa kayitli sertifika korunur)"></textarea>
+                <label class="check">
+                    <input type="checkbox" name="tb_ca_clear" value="1"> Kayitli CA sertifikasini sil (yerlesik CA paketi)
+                </label>
+                <label class="check">
+                    <input type="checkbox" name="tb_proto" value="1")rawhtml";
+    html += _config.tbProto ? " checked" : "";
+    html += R"rawhtml(> Protobuf (cihaz profili Protobuf olmali)
+                </label>
             </div>
             
             <button type="submit" class="btn-primary">Kaydet ve Baglan</button>
@@ -404,14 +517,18 @@ String ConfigManager::generateHTML() {
     return html;
 }
 
-String ConfigManager::generateStatusJSON() {
-    String json = "{";
-    json += "\"configured\":" + String(_config.configured ? "true" : "false") + ",";
-    json += "\"wifi_ssid\":\"" + String(_config.wifiSsid) + "\",";
-    json += "\"tb_server\":\"" + String(_config.tbServer) + "\",";
-    json += "\"tb_port\":" + String(_config.tbPort) + ",";
-    json += "\"firmware\":\"" + String(FIRMWARE_VERSION) + "\",";
-    json += "\"mac\":\"" + WiFi.macAddress() + "\"";
-    json += "}";
-    return json;
+void ConfigManager::generateStatusJSON(JsonWriter& json) {
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    
+    json.beginObject();
+    json.add("configured", _config.configured);
+    json.add("wifi_ssid", _config.wifiSsid);
+    json.add("tb_server", _config.tbServer);
+    json.add("tb_port", _config.tbPort);
+    json.add("tb_tls", _config.tbTls);
+    json.add("tb_proto", _config.tbProto);
+    json.add("firmware", FIRMWARE_VERSION);
+    json.addf("mac", "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    json.endObject();
 }
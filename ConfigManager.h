@@ -7,6 +7,7 @@
 #include <WebServer.h>
 #include <DNSServer.h>
 #include "Config.h"
+#include "JsonWriter.h"
 
 struct DeviceConfig {
     char wifiSsid[64];
@@ -14,9 +15,23 @@ struct DeviceConfig {
     char tbServer[128];
     uint16_t tbPort;
     char tbToken[64];
+    bool tbTls;         // MQTT over TLS (CA sertifikası ayrı saklanır: loadCaCert)
+    bool tbProto;       // Telemetry/attribute/RPC yanıtları protobuf (cihaz profili Protobuf olmalı)
     bool configured;
 };
 
+// Son başarılı WiFi bağlantısı - tarama ve DHCP'siz hızlı yeniden bağlanma için.
+// Portalda yeni ayar kaydedilince silinir.
+struct WiFiCache {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+};
+
 class ConfigManager {
 public:
     ConfigManager();
@@ -28,6 +43,19 @@ public:
     bool saveConfig();
     void resetConfig();
     
+    // TLS CA sertifikası (PEM) - RAM'de tutulmaz, gerektiğinde NVS'ten okunur
+    size_t loadCaCert(char* buf, size_t size);     // 0: kayıtlı sertifika yok
+    bool saveCaCert(const char* pem);               // Boş: sil (yerleşik CA paketi)
+    
+    // WiFi hızlı bağlanma önbelleği
+    bool loadWiFiCache(WiFiCache& cache);           // false: kayıt yok
+    void saveWiFiCache(const WiFiCache& cache);
+    void clearWiFiCache();
+    
+    // Son uygulanan istenen röle durumu (shared attribute'lar): mask << 8 | states
+    uint16_t loadDesiredRelays();                   // 0: kayıt yok
+    void saveDesiredRelays(uint16_t desired);
+    
     // AP Mode portal
     void startAPMode();
     void stopAPMode();
@@ -59,7 +87,7 @@ private:
     void handleReset();
     
     String generateHTML();
-    String generateStatusJSON();
+    void generateStatusJSON(JsonWriter& json);
 };
 
 extern ConfigManager Config;
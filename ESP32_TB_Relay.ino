@@ -8,7 +8,12 @@
  * Features:
  * - WiFi configuration via captive portal (AP mode)
  * - ThingsBoard MQTT integration with RPC support
- * - 6-channel relay control
+ * - 6-channel relay control (dedicated high-priority task on core 1)
+ * - RS485 Modbus RTU master, meters published via ThingsBoard gateway API
+ * - RS485 Modbus RTU slave, relays controlled locally by a PLC
+ * - I2C sensors aggregated on-device (min/max/mean per telemetry window)
+ * - Local relay scheduler (cron rules and one-shot timers, runs offline)
+ * - Event-driven network loop with DFS and optional WiFi modem sleep
  * - OTA firmware updates
  * - RGB LED status indicator
  * - Buzzer feedback
@@ -30,10 +35,22 @@
 
 #include "Config.h"
 #include "RelayController.h"
+#include "RelayActuator.h"
+#include "RelayJournal.h"
+#include "EventLoop.h"
+#include "BootProfile.h"
+#include "PerfStats.h"
+#include "WiFiLink.h"
 #include "StatusLED.h"
 #include "ConfigManager.h"
 #include "ThingsBoardMQTT.h"
+#include "TelemetryQueue.h"
 #include "OTAHandler.h"
+#include "ModbusMaster.h"
+#include "ModbusSlave.h"
+#include "SensorHub.h"
+#include "SensorDrivers.h"
+#include "RelayScheduler.h"
 #include "Buzzer.h"
 
 // ============================================
@@ -52,10 +69,36 @@ DeviceState currentState = DeviceState::BOOT;
 unsigned long stateEnteredAt = 0;
 unsigned long lastWiFiAttempt = 0;
 int wifiRetryCount = 0;
+bool wifiStartedEarly = false;  // FAST_BOOT: ilişkilendirme setup() içinde başladı
 
 #define WIFI_MAX_RETRIES 10
 #define WIFI_RETRY_INTERVAL_MS 5000
 
+#if MODBUS_MODE == MODBUS_MODE_MASTER
+// ============================================
+// Modbus poll tablosu (gateway alt cihazları)
+// ============================================
+// Örnek: Eastron SDM120 enerji sayacı, slave 1, input register'lar (float).
+// voltage/current/power tek istekte okunur, frequency ayrı istekte.
+const ModbusPoint modbusPoints[] = {
+    { "SDM120-1", "voltage",   1, MODBUS_FC_READ_INPUT, 0x0000, ModbusType::F32, 1.0f },
+    { "SDM120-1", "current",   1, MODBUS_FC_READ_INPUT, 0x0006, ModbusType::F32, 1.0f },
+    { "SDM120-1", "power",     1, MODBUS_FC_READ_INPUT, 0x000C, ModbusType::F32, 1.0f },
+    { "SDM120-1", "frequency", 1, MODBUS_FC_READ_INPUT, 0x0046, ModbusType::F32, 1.0f },
+};
+#endif
+
+#if SENSOR_ENABLED
+// ============================================
+// I2C sensör tablosu
+// ============================================
+static const char* const sht3xKeys[] = { "temperature", "humidity" };
+
+const SensorDef sensorTable[] = {
+    { "SHT31", SHT3X_ADDRESS, 2, sht3xKeys, sht3xBegin, sht3xRead },
+};
+#endif
+
 // ============================================
 // Forward declarations
 // ============================================
@@ -66,14 +109,40 @@ void handleWiFiConnecting();
 void handleMQTTConnecting();
 void handleConnected();
 void handleError();
-void onRelayChange(uint8_t channel, bool state);
+void runStateMachine();
+void networkTask(void* param);
+void handleRelayChanges();
+void onRelayChange(const RelayChange& change);
+void onOTAStart();
+void onWiFiEvent(arduino_event_id_t event);
+void beginWiFi();
 
 // ============================================
 // Setup
 // ============================================
 void setup() {
     Serial.begin(SERIAL_BAUD);
-    delay(1000);
+    
+    // Röleler ilk iş: kayıtlı durumlar WiFi ve diğer modüllerden önce geri yüklenir
+    Relays.begin(Journal.begin());
+    Actuator.begin();   // Röle task'ı (core 1) - Relays'in tek yazarı
+    Boot.mark(BootPhase::RELAYS_RESTORED);
+    
+    // Olay döngüsü ve güç yönetimi - uyandıran task'lar başlamadan
+    Events.begin();
+    WiFi.onEvent(onWiFiEvent);
+    
+    Config.begin();
+    
+#if FAST_BOOT
+    // WiFi ilişkilendirme / DHCP, aşağıdaki modüller başlatılırken arka planda ilerler
+    if (Config.isConfigured()) {
+        beginWiFi();
+        wifiStartedEarly = true;
+    }
+#else
+    delay(1000);    // USB CDC seri monitörün bağlanması için
+#endif
     
     DEBUG_PRINTLN("\n\n");
     DEBUG_PRINTLN("============================================");
@@ -88,60 +157,117 @@ void setup() {
         .trigger_panic = true
     };
     esp_task_wdt_init(&wdt_config);
-    esp_task_wdt_add(NULL);
     
     // Modülleri başlat
     Led.begin();
     Led.setStatus(LedStatus::BOOT);
     
     Buzz.begin();
-    Buzz.bootSound();
+    Buzz.bootSound();   // Bloklamaz - esp_timer ile arka planda çalar
     
-    Relays.begin();
-    Relays.setOnChangeCallback(onRelayChange);
+    Backlog.begin();
     
-    Config.begin();
+    Schedule.begin();   // Zamanlayıcı task'ı (core 1) - bulut bağlantısından bağımsız
+    Perf.begin();
+    
+#if MODBUS_MODE == MODBUS_MODE_MASTER
+    for (const ModbusPoint& point : modbusPoints) {
+        Gateway.addPoint(point);
+    }
+    Gateway.begin();
+#elif MODBUS_MODE == MODBUS_MODE_SLAVE
+    LocalModbus.begin();    // WiFi / ThingsBoard'dan bağımsız yerel kontrol
+#endif
+    
+#if SENSOR_ENABLED
+    for (const SensorDef& sensor : sensorTable) {
+        Sensors.addSensor(sensor);
+    }
+    Sensors.begin();
+#endif
     
     // Boot durumuna geç
     changeState(DeviceState::BOOT);
+    Boot.mark(BootPhase::SETUP_DONE);
+    
+    // Ağ, portal, MQTT, OTA ve LED core 0'daki ağ task'ında
+    xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK, NULL,
+                            NETWORK_TASK_PRIORITY, NULL, NETWORK_TASK_CORE);
 }
 
 // ============================================
 // Main Loop
 // ============================================
 void loop() {
-    // Watchdog besle
-    esp_task_wdt_reset();
+    // Tüm iş task'larda - Arduino loop task'ı core 1'i röle task'ına bırakır
+    vTaskDelete(NULL);
+}
+
+// ============================================
+// Network Task (core 0)
+// ============================================
+void networkTask(void* param) {
+    esp_task_wdt_add(NULL);
     
-    // LED güncelle
-    Led.update();
+    for (;;) {
+        // Watchdog besle
+        esp_task_wdt_reset();
+        
+        // LED güncelle
+        int64_t t0 = PerfStats::now();
+        Led.update();
+        Perf.record(PerfProbe::LED_UPDATE, t0);
+        
+        // Röle task'ından gelen durum değişiklikleri
+        handleRelayChanges();
+        
+        // Kalıcı röle durumları - birleştirilerek NVS'e
+        Journal.record(Actuator.getSettledStates());
+        Journal.loop();
+        
+        // Durum makinesi
+        runStateMachine();
+        
+        // Olay (MQTT soketi, röle değişikliği, WiFi) ya da en yakın zamana kadar uyu
+        Events.wait();
+    }
+}
+
+static_assert((uint8_t)PerfProbe::STATE_ERROR - (uint8_t)PerfProbe::STATE_BOOT == (uint8_t)DeviceState::ERROR,
+              "PerfProbe::STATE_* must match DeviceState");
+
+void runStateMachine() {
+    // Handler süresi durum başına (PerfProbe::STATE_* DeviceState sırasında)
+    DeviceState state = currentState;
+    int64_t t0 = PerfStats::now();
     
-    // Durum makinesi
-    switch (currentState) {
+    switch (state) {
         case DeviceState::BOOT:
             handleBoot();
             break;
-            
+        
         case DeviceState::AP_MODE:
             handleAPMode();
             break;
-            
+        
         case DeviceState::WIFI_CONNECTING:
             handleWiFiConnecting();
             break;
-            
+        
         case DeviceState::MQTT_CONNECTING:
             handleMQTTConnecting();
             break;
-            
+        
         case DeviceState::CONNECTED:
             handleConnected();
             break;
-            
+        
         case DeviceState::ERROR:
             handleError();
             break;
     }
+    
+    Perf.record((PerfProbe)((uint8_t)PerfProbe::STATE_BOOT + (uint8_t)state), t0);
 }
 
 // ============================================
@@ -155,36 +281,46 @@ void changeState(DeviceState newState) {
     
     currentState = newState;
     stateEnteredAt = millis();
+    Events.dueIn(0);    // Yeni durumun handler'ı beklemeden çalışır
     
     switch (newState) {
         case DeviceState::BOOT:
             Led.setStatus(LedStatus::BOOT);
             break;
-            
+        
         case DeviceState::AP_MODE:
             Led.setStatus(LedStatus::AP_MODE);
             Config.startAPMode();
             DEBUG_PRINTLN("\n>>> AP Mode: Connect to WiFi 'ESP32-Relay-Setup' with password '12345678' <<<\n");
             break;
-            
+        
         case DeviceState::WIFI_CONNECTING:
             Led.setStatus(LedStatus::WIFI_CONNECTING);
             wifiRetryCount = 0;
             lastWiFiAttempt = 0;
-            break;
             
+            // setup()'ta başlayan deneme ilk deneme sayılır, yeniden başlatılmaz
+            if (wifiStartedEarly) {
+                wifiStartedEarly = false;
+                wifiRetryCount = 1;
+                lastWiFiAttempt = millis();
+            }
+            break;
+        
         case DeviceState::MQTT_CONNECTING:
             Led.setStatus(LedStatus::MQTT_CONNECTING);
             TB.begin();
             break;
-            
+        
         case DeviceState::CONNECTED:
+            Boot.mark(BootPhase::MQTT_UP);
             Led.setStatus(LedStatus::CONNECTED);
+            OTA.setOnStart(onOTAStart);
             OTA.begin();
             Buzz.successSound();
             DEBUG_PRINTLN("\n>>> CONNECTED - System Ready <<<\n");
             break;
-            
+        
         case DeviceState::ERROR:
             Led.setStatus(LedStatus::ERROR);
             Buzz.errorSound();
@@ -193,7 +329,9 @@ void changeState(DeviceState newState) {
 }
 
 void handleBoot() {
+#if !FAST_BOOT
     delay(500);
+#endif
     
     if (Config.isConfigured()) {
         DEBUG_PRINTLN("[Boot] Configuration found, connecting to WiFi...");
@@ -206,6 +344,7 @@ void handleBoot() {
 
 void handleAPMode() {
     Config.handlePortal();
+    Events.dueIn(LOOP_POLL_MS);     // Web sunucusu ve DNS yoklamalı
     
     // AP mode timeout
     if (!Config.isAPModeActive()) {
@@ -222,10 +361,25 @@ void handleWiFiConnecting() {
     // WiFi bağlı mı kontrol et
     if (WiFi.status() == WL_CONNECTED) {
         DEBUG_PRINTF("[WiFi] Connected! IP: %s\n", WiFi.localIP().toString().c_str());
+        Boot.mark(BootPhase::WIFI_UP);
+        Link.onConnected();
+        
+        // SNTP - çevrimdışı olay zaman damgaları ve zamanlayıcı için (bir kez başlatılır, arka planda senkronize olur)
+        static bool sntpStarted = false;
+        if (!sntpStarted) {
+            configTzTime(LOCAL_TIMEZONE, NTP_SERVER_1, NTP_SERVER_2);
+            sntpStarted = true;
+        }
+        
         changeState(DeviceState::MQTT_CONNECTING);
         return;
     }
     
+    // Hızlı deneme tutmadıysa aynı deneme tam tarama ile sürer
+    if (Link.poll()) {
+        lastWiFiAttempt = millis();
+    }
+    
     unsigned long now = millis();
     
     // Bağlantı denemesi
@@ -240,13 +394,13 @@ void handleWiFiConnecting() {
             return;
         }
         
-        DeviceConfig& cfg = Config.getConfig();
         DEBUG_PRINTF("[WiFi] Connecting to '%s' (attempt %d/%d)...\n", 
-                     cfg.wifiSsid, wifiRetryCount, WIFI_MAX_RETRIES);
-        
-        WiFi.mode(WIFI_STA);
-        WiFi.begin(cfg.wifiSsid, cfg.wifiPassword);
+                     Config.getConfig().wifiSsid, wifiRetryCount, WIFI_MAX_RETRIES);
+        beginWiFi();
     }
+    
+    // Bağlantı WiFi olayıyla uyandırır; yoksa bir sonraki deneme
+    Events.dueAt(lastWiFiAttempt + WIFI_RETRY_INTERVAL_MS + 1);
 }
 
 void handleMQTTConnecting() {
@@ -257,12 +411,16 @@ void handleMQTTConnecting() {
         return;
     }
     
-    // MQTT bağlantı dene
-    if (TB.connect()) {
+    // Önbellekteki statik IP'yi ağ geçidine ARP ile doğrula
+    Link.loop();
+    
+    // MQTT bağlantı durum makinesini ilerlet (bloklamaz, backoff TB içinde)
+    int64_t t0 = PerfStats::now();
+    TB.loop();
+    Perf.record(PerfProbe::TB_LOOP, t0);
+    
+    if (TB.isConnected()) {
         changeState(DeviceState::CONNECTED);
-    } else {
-        // 5 saniye bekle ve tekrar dene
-        delay(MQTT_RECONNECT_DELAY_MS);
     }
 }
 
@@ -283,8 +441,25 @@ void handleConnected() {
     }
     
     // Normal işlemler
+    int64_t t0 = PerfStats::now();
     TB.loop();
+    Perf.record(PerfProbe::TB_LOOP, t0);
+    
+    t0 = PerfStats::now();
     OTA.loop();
+    Perf.record(PerfProbe::OTA_LOOP, t0);
+    
+#if MODBUS_MODE == MODBUS_MODE_MASTER
+    Gateway.loop();
+#endif
+    
+#if SENSOR_ENABLED
+    Sensors.loop();
+#endif
+    
+    Schedule.loop();
+    Boot.loop();
+    Perf.loop();
 }
 
 void handleError() {
@@ -292,23 +467,43 @@ void handleError() {
     if (millis() - stateEnteredAt > 10000) {
         ESP.restart();
     }
+    Events.dueAt(stateEnteredAt + 10001);
 }
 
 // ============================================
 // Callbacks
 // ============================================
 
-void onRelayChange(uint8_t channel, bool state) {
-    DEBUG_PRINTF("[Callback] Relay %d changed to %s\n", channel, state ? "ON" : "OFF");
+void handleRelayChanges() {
+    RelayChange change;
+    while (Actuator.pollChange(change)) {
+        onRelayChange(change);
+    }
+}
+
+void onRelayChange(const RelayChange& change) {
+    DEBUG_PRINTF("[Callback] Relays changed: mask=0x%02X states=0x%02X\n", change.changed, change.states);
     
-    // LED flash
-    Led.flash(state ? LED_COLOR_GREEN : LED_COLOR_RED, 100);
+    // LED flash - açılan kanal varsa yeşil
+    Led.flash((change.changed & change.states) ? LED_COLOR_GREEN : LED_COLOR_RED, 100);
     
     // Buzzer click
     Buzz.clickSound();
     
-    // MQTT bağlıysa telemetry gönder
-    if (currentState == DeviceState::CONNECTED && TB.isConnected()) {
-        TB.sendTelemetry();
-    }
+    // Telemetry birleştiriciyi işaretle - TB.loop() tick sonunda tek mesaj gönderir
+    TB.markRelaysDirty(change.changed, change.states);
+}
+
+void onOTAStart() {
+    // Güncelleme sonrası yeniden başlatmada bekleyen durum kaybolmasın
+    Journal.flush();
+}
+
+void onWiFiEvent(arduino_event_id_t event) {
+    // Bağlandı / koptu: durum makinesi bir sonraki zamanı beklemeden çalışır
+    Events.wake();
+}
+
+void beginWiFi() {
+    Link.connect();     // Önbellek varsa taramasız, statik IP ile
 }
@@ -0,0 +1,129 @@
+#include "EventLoop.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_pm.h>
+#include <esp_vfs_eventfd.h>
+#include <lwip/sockets.h>
+#include "PerfStats.h"
+
+EventLoop Events;
+
+EventLoop::EventLoop() {
+    _eventFd = -1;
+    _watchFd = -1;
+    _watchWrite = false;
+    _timeoutMs = LOOP_MAX_IDLE_MS;
+    _passStart = 0;
+}
+
+void EventLoop::begin() {
+    // eventfd: diğer task'lar select()'te bekleyen ağ task'ını uyandırabilir
+    esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    if (esp_vfs_eventfd_register(&config) == ESP_OK) {
+        _eventFd = eventfd(0, 0);
+    }
+    if (_eventFd < 0) {
+        DEBUG_PRINTF("[Loop] eventfd unavailable, polling every %d ms\n", LOOP_POLL_MS);
+    }
+
+#if POWER_SAVE_ENABLED
+    // Çekirdekte CONFIG_PM_ENABLE yoksa hata döner - yalnızca (açıksa) modem uyku kalır
+    esp_pm_config_t pm = {};
+    pm.max_freq_mhz = POWER_CPU_MAX_MHZ;
+    pm.min_freq_mhz = POWER_CPU_MIN_MHZ;
+    pm.light_sleep_enable = POWER_LIGHT_SLEEP;
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err == ESP_OK) {
+        DEBUG_PRINTF("[Loop] DFS %d-%d MHz, light sleep %s\n", POWER_CPU_MIN_MHZ, POWER_CPU_MAX_MHZ,
+                     POWER_LIGHT_SLEEP ? "on" : "off");
+    } else {
+        DEBUG_PRINTF("[Loop] Power management unavailable: %s\n", esp_err_to_name(err));
+    }
+#endif
+}
+
+void EventLoop::wake() {
+    if (_eventFd >= 0) {
+        uint64_t one = 1;
+        write(_eventFd, &one, sizeof(one));
+    }
+}
+
+void EventLoop::dueAt(unsigned long atMs) {
+    long remaining = (long)(atMs - millis());
+    dueIn(remaining > 0 ? (uint32_t)remaining : 0);
+}
+
+void EventLoop::dueIn(uint32_t ms) {
+    if (ms < _timeoutMs) {
+        _timeoutMs = ms;
+    }
+}
+
+void EventLoop::watch(int fd, bool writable) {
+    _watchFd = fd;
+    _watchWrite = writable;
+}
+
+void EventLoop::wait() {
+    uint32_t timeout = _timeoutMs;
+    int fd = _watchFd;
+    bool writable = _watchWrite;
+    _timeoutMs = LOOP_MAX_IDLE_MS;
+    _watchFd = -1;
+    _watchWrite = false;
+    
+    int64_t start = PerfStats::now();
+    bool timedOut = sleep(timeout, fd, writable);
+    int64_t woke = PerfStats::now();
+    
+    if (_passStart != 0) {
+        Perf.add(PerfProbe::LOOP_BUSY, (uint32_t)(start - _passStart));
+        Perf.add(PerfProbe::LOOP_PERIOD, (uint32_t)(woke - _passStart));
+    }
+    // Jitter: istenen zamandan ne kadar sonra uyandık (DFS / modem uyku / yüksek öncelikli task'lar)
+    if (timedOut) {
+        int64_t late = (woke - start) - (int64_t)timeout * 1000;
+        Perf.add(PerfProbe::LOOP_LATE, late > 0 ? (uint32_t)late : 0);
+    }
+    _passStart = woke;
+}
+
+bool EventLoop::sleep(uint32_t timeout, int fd, bool writable) {
+    // Bekleyen iş var: yalnızca aynı çekirdekteki idle task'a zaman bırak (task watchdog)
+    if (timeout == 0) {
+        vTaskDelay(1);
+        return false;
+    }
+    
+    if (_eventFd < 0) {
+        vTaskDelay(pdMS_TO_TICKS(min(timeout, (uint32_t)LOOP_POLL_MS)));
+        return timeout <= LOOP_POLL_MS;
+    }
+    
+    fd_set readFds;
+    FD_ZERO(&readFds);
+    FD_SET(_eventFd, &readFds);
+    fd_set writeFds;
+    FD_ZERO(&writeFds);
+    if (fd >= 0) {
+        FD_SET(fd, &readFds);
+        if (writable) {
+            FD_SET(fd, &writeFds);
+        }
+    }
+    
+    struct timeval tv;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    
+    int n = select(max(_eventFd, fd) + 1, &readFds, writable ? &writeFds : nullptr, nullptr, &tv);
+    if (n > 0 && FD_ISSET(_eventFd, &readFds)) {
+        uint64_t count;
+        read(_eventFd, &count, sizeof(count));
+    } else if (n < 0) {
+        // Soket tur içinde kapandıysa (EBADF) bir sonraki tur izlemez
+        vTaskDelay(1);
+    }
+    return n == 0;
+}
@@ -0,0 +1,39 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Ağ task'ının olay döngüsü: her tur modüller bir sonraki çalışma zamanlarını
+// (dueAt / dueIn) ve izlenecek soketi (watch) bildirir, tur sonunda wait()
+// soket okunabilir olana, başka bir task wake() çağırana ya da en yakın
+// zamana kadar uyur. Boşta CPU, DFS / light sleep ile düşük saatte bekler.
+class EventLoop {
+public:
+    EventLoop();
+    
+    // setup() başında, diğer task'lar başlamadan: eventfd ve güç yönetimi
+    void begin();
+    
+    // Her task'tan (ISR hariç): ağ task'ını hemen uyandır
+    void wake();
+    
+    // Yalnızca ağ task'ı, tur içinde
+    void dueAt(unsigned long atMs);     // millis() zamanı
+    void dueIn(uint32_t ms);
+    void watch(int fd, bool writable = false);  // Tur başına tek soket (MQTT); writable: yazılabilirliği de bekle
+    void wait();
+
+private:
+    int _eventFd;
+    int _watchFd;
+    bool _watchWrite;
+    uint32_t _timeoutMs;
+    int64_t _passStart;     // Tur başlangıcı (µs) - Perf ölçümleri
+    
+    bool sleep(uint32_t timeout, int fd, bool writable);   // true: zaman aşımıyla uyandı
+};
+
+extern EventLoop Events;
+
+#endif // EVENT_LOOP_H
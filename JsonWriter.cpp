@@ -0,0 +1,312 @@
+#include "JsonWriter.h"
+#include <stdarg.h>
+
+JsonWriter::JsonWriter(char* buf, size_t size) {
+    _buf = buf;
+    _size = size;
+    _sink = nullptr;
+    _sinkCtx = nullptr;
+    reset();
+}
+
+JsonWriter::JsonWriter(char* buf, size_t size, JsonSink sink, void* ctx) {
+    _buf = buf;
+    _size = size;
+    _sink = sink;
+    _sinkCtx = ctx;
+    reset();
+}
+
+void JsonWriter::reset() {
+    _len = 0;
+    _flushed = 0;
+    _overflow = (_size == 0);
+    _depth = 0;
+    _needComma = 0;
+    if (_size > 0) {
+        _buf[0] = '\0';
+    }
+}
+
+// ========== Yapılar ==========
+
+void JsonWriter::beginObject() {
+    separator();
+    open('{');
+}
+
+void JsonWriter::beginObject(const char* k) {
+    key(k);
+    open('{');
+}
+
+void JsonWriter::endObject() {
+    close('}');
+}
+
+void JsonWriter::beginArray() {
+    separator();
+    open('[');
+}
+
+void JsonWriter::beginArray(const char* k) {
+    key(k);
+    open('[');
+}
+
+void JsonWriter::endArray() {
+    close(']');
+}
+
+// ========== Nesne alanları ==========
+
+void JsonWriter::add(const char* k, const char* v) {
+    key(k);
+    string(v);
+}
+
+void JsonWriter::add(const char* k, bool v) {
+    key(k);
+    raw(v ? "true" : "false");
+}
+
+void JsonWriter::add(const char* k, int v) {
+    key(k);
+    integer(v);
+}
+
+void JsonWriter::add(const char* k, unsigned int v) {
+    key(k);
+    uinteger(v);
+}
+
+void JsonWriter::add(const char* k, long v) {
+    key(k);
+    integer(v);
+}
+
+void JsonWriter::add(const char* k, unsigned long v) {
+    key(k);
+    uinteger(v);
+}
+
+void JsonWriter::add(const char* k, long long v) {
+    key(k);
+    integer(v);
+}
+
+void JsonWriter::add(const char* k, unsigned long long v) {
+    key(k);
+    uinteger(v);
+}
+
+void JsonWriter::add(const char* k, float v, uint8_t decimals) {
+    key(k);
+    if (isnan(v) || isinf(v)) {
+        raw("null");
+        return;
+    }
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%.*f", decimals, (double)v);
+    raw(tmp, n);
+}
+
+void JsonWriter::addf(const char* k, const char* format, ...) {
+    char tmp[96];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(tmp, sizeof(tmp), format, args);
+    va_end(args);
+    
+    key(k);
+    string(tmp);
+}
+
+void JsonWriter::addRaw(const char* k, const char* json) {
+    key(k);
+    raw(json);
+}
+
+// ========== Dizi elemanları ==========
+
+void JsonWriter::value(const char* v) {
+    separator();
+    string(v);
+}
+
+void JsonWriter::value(bool v) {
+    separator();
+    raw(v ? "true" : "false");
+}
+
+void JsonWriter::value(int v) {
+    separator();
+    integer(v);
+}
+
+void JsonWriter::value(unsigned int v) {
+    separator();
+    uinteger(v);
+}
+
+void JsonWriter::value(long v) {
+    separator();
+    integer(v);
+}
+
+void JsonWriter::value(unsigned long v) {
+    separator();
+    uinteger(v);
+}
+
+void JsonWriter::value(long long v) {
+    separator();
+    integer(v);
+}
+
+void JsonWriter::value(unsigned long long v) {
+    separator();
+    uinteger(v);
+}
+
+// ========== Sonuç ==========
+
+void JsonWriter::flush() {
+    if (_sink == nullptr || _overflow || _len == 0) return;
+    
+    if (!_sink(_sinkCtx, _buf, _len)) {
+        _overflow = true;
+        return;
+    }
+    _flushed += _len;
+    _len = 0;
+    _buf[0] = '\0';
+}
+
+const char* JsonWriter::c_str() const {
+    return _buf;
+}
+
+size_t JsonWriter::length() const {
+    return _flushed + _len;
+}
+
+bool JsonWriter::overflowed() const {
+    return _overflow;
+}
+
+// ========== Dahili ==========
+
+void JsonWriter::separator() {
+    if (_depth == 0) return;
+    
+    uint8_t bit = 1 << (_depth - 1);
+    if (_needComma & bit) {
+        rawChar(',');
+    } else {
+        _needComma |= bit;
+    }
+}
+
+void JsonWriter::key(const char* k) {
+    separator();
+    string(k);
+    rawChar(':');
+}
+
+void JsonWriter::raw(const char* str) {
+    raw(str, strlen(str));
+}
+
+void JsonWriter::raw(const char* str, size_t len) {
+    if (_overflow) return;
+    
+    // Sonlandırıcı için bir bayt ayır
+    if (_len + len >= _size) {
+        if (_sink == nullptr) {
+            _overflow = true;
+            return;
+        }
+        
+        flush();
+        if (_overflow) return;
+        
+        // Tampondan büyük parça doğrudan sink'e
+        if (len >= _size) {
+            if (!_sink(_sinkCtx, str, len)) {
+                _overflow = true;
+                return;
+            }
+            _flushed += len;
+            return;
+        }
+    }
+    memcpy(_buf + _len, str, len);
+    _len += len;
+    _buf[_len] = '\0';
+}
+
+void JsonWriter::rawChar(char c) {
+    raw(&c, 1);
+}
+
+void JsonWriter::string(const char* str) {
+    rawChar('"');
+    
+    if (str) {
+        const char* start = str;
+        for (const char* p = str; *p; p++) {
+            char c = *p;
+            if (c != '"' && c != '\\' && (uint8_t)c >= 0x20) continue;
+            
+            raw(start, p - start);
+            start = p + 1;
+            
+            switch (c) {
+                case '"':  raw("\\\"", 2); break;
+                case '\\': raw("\\\\", 2); break;
+                case '\n': raw("\\n", 2); break;
+                case '\r': raw("\\r", 2); break;
+                case '\t': raw("\\t", 2); break;
+                default: {
+                    char esc[7];
+                    snprintf(esc, sizeof(esc), "\\u%04x", (uint8_t)c);
+                    raw(esc, 6);
+                    break;
+                }
+            }
+        }
+        raw(start);
+    }
+    
+    rawChar('"');
+}
+
+void JsonWriter::integer(long long v) {
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%lld", v);
+    raw(tmp, n);
+}
+
+void JsonWriter::uinteger(unsigned long long v) {
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%llu", v);
+    raw(tmp, n);
+}
+
+void JsonWriter::open(char c) {
+    rawChar(c);
+    if (_depth >= MAX_DEPTH) {
+        _overflow = true;
+        return;
+    }
+    _depth++;
+    _needComma &= ~(1 << (_depth - 1));
+}
+
+void JsonWriter::close(char c) {
+    if (_depth > 0) {
+        _depth--;
+    }
+    rawChar(c);
+}
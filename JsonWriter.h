@@ -0,0 +1,92 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+// Sabit tampona yazan, heap kullanmayan JSON yazıcı.
+// Tampon çağıranındır (genelde stack). Taşma olursa overflowed() true döner
+// ve çıktı geçersiz sayılmalıdır.
+//
+//   char buf[JSON_BUFFER_SIZE];
+//   JsonWriter json(buf, sizeof(buf));
+//   json.beginObject();
+//   json.add("relay1", true);
+//   json.endObject();
+//   publish(topic, json.c_str(), json.length());
+//
+// Akış modu: tampon dolunca içerik sink'e aktarılır, çıktı boyutu tamponla
+// sınırlı değildir. Sonda flush() çağrılmalı; c_str() anlamsızdır.
+
+// false: yazılamadı (çıktı overflowed() olarak işaretlenir)
+typedef bool (*JsonSink)(void* ctx, const char* data, size_t len);
+
+class JsonWriter {
+public:
+    static const uint8_t MAX_DEPTH = 8;
+    
+    JsonWriter(char* buf, size_t size);
+    JsonWriter(char* buf, size_t size, JsonSink sink, void* ctx);
+    
+    void reset();
+    
+    // Yapılar
+    void beginObject();
+    void beginObject(const char* key);
+    void endObject();
+    void beginArray();
+    void beginArray(const char* key);
+    void endArray();
+    
+    // Nesne alanları
+    void add(const char* key, const char* value);
+    void add(const char* key, bool value);
+    void add(const char* key, int value);
+    void add(const char* key, unsigned int value);
+    void add(const char* key, long value);
+    void add(const char* key, unsigned long value);
+    void add(const char* key, long long value);
+    void add(const char* key, unsigned long long value);
+    void add(const char* key, float value, uint8_t decimals = 2);
+    void addf(const char* key, const char* format, ...);   // printf ile string değer
+    void addRaw(const char* key, const char* json);         // Hazır JSON parçası
+    
+    // Dizi elemanları
+    void value(const char* value);
+    void value(bool value);
+    void value(int value);
+    void value(unsigned int value);
+    void value(long value);
+    void value(unsigned long value);
+    void value(long long value);
+    void value(unsigned long long value);
+    
+    void flush();   // Akış modu: tamponda kalanı sink'e aktar
+    
+    const char* c_str() const;
+    size_t length() const;  // Akış modunda sink'e aktarılanlar dahil toplam
+    bool overflowed() const;
+
+private:
+    char* _buf;
+    size_t _size;
+    size_t _len;
+    JsonSink _sink;
+    void* _sinkCtx;
+    size_t _flushed;
+    bool _overflow;
+    uint8_t _depth;
+    uint8_t _needComma;     // Her derinlik için bir bit
+    
+    void separator();
+    void key(const char* key);
+    void raw(const char* str);
+    void raw(const char* str, size_t len);
+    void rawChar(char c);
+    void string(const char* str);
+    void integer(long long value);
+    void uinteger(unsigned long long value);
+    void open(char c);
+    void close(char c);
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,525 @@
+#include "MQTTTransport.h"
+#include <lwip/sockets.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mbedtls/net_sockets.h>
+#include <esp_crt_bundle.h>
+#include <esp_random.h>
+
+MQTTTransport::MQTTTransport() {
+    _pendingFd = -1;
+    _fakeLen = 0;
+    _fakePos = 0;
+    _tls = false;
+    _tlsConfigured = false;
+    _fd = -1;
+    _sslActive = false;
+    _tlsOpen = false;
+    _peerClosed = false;
+    _peekByte = -1;
+    _txLen = 0;
+    _txRetryLen = 0;
+    _handshakeStart = 0;
+    _resumeOffered = false;
+    _sessionValid = false;
+    memset(&_stats, 0, sizeof(_stats));
+    
+    mbedtls_ssl_config_init(&_conf);
+    mbedtls_x509_crt_init(&_ca);
+    mbedtls_ssl_session_init(&_session);
+}
+
+bool MQTTTransport::setTls(bool enabled, const char* caPem) {
+    stop();
+    clearSession();
+    _tls = enabled;
+    
+    if (_tlsConfigured) {
+        mbedtls_ssl_config_free(&_conf);
+        mbedtls_x509_crt_free(&_ca);
+        mbedtls_ssl_config_init(&_conf);
+        mbedtls_x509_crt_init(&_ca);
+        _tlsConfigured = false;
+    }
+    
+    if (!enabled) {
+        return true;
+    }
+    
+    int ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        DEBUG_PRINTF("[Transport] TLS config failed: -0x%04X\n", -ret);
+        return false;
+    }
+    
+    if (caPem != nullptr && caPem[0] != '\0') {
+        ret = mbedtls_x509_crt_parse(&_ca, (const unsigned char*)caPem, strlen(caPem) + 1);
+        if (ret != 0) {
+            DEBUG_PRINTF("[Transport] CA certificate parse failed: -0x%04X\n", -ret);
+            return false;
+        }
+        mbedtls_ssl_conf_ca_chain(&_conf, &_ca, NULL);
+        DEBUG_PRINTLN("[Transport] TLS using configured CA certificate");
+    } else {
+        esp_crt_bundle_attach(&_conf);
+        DEBUG_PRINTLN("[Transport] TLS using built-in CA bundle");
+    }
+    
+    mbedtls_ssl_conf_authmode(&_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_rng(&_conf, tlsRandom, NULL);
+    
+    // Oturum devamı: TLS 1.2 session ID + session ticket. TLS 1.3'te bilet
+    // handshake sonrasında geldiğinden get_session() ile yakalanamaz.
+    mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    mbedtls_ssl_conf_max_tls_version(&_conf, MBEDTLS_SSL_VERSION_TLS1_2);
+    
+    _tlsConfigured = true;
+    return true;
+}
+
+bool MQTTTransport::isTls() {
+    return _tls;
+}
+
+bool MQTTTransport::beginConnect(IPAddress ip, uint16_t port) {
+    stop();
+    
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        DEBUG_PRINTF("[Transport] socket() failed, errno=%d\n", errno);
+        return false;
+    }
+    
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+    
+    int res = ::connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+    if (res < 0 && errno != EINPROGRESS) {
+        DEBUG_PRINTF("[Transport] connect() failed, errno=%d\n", errno);
+        close(fd);
+        return false;
+    }
+    
+    _pendingFd = fd;
+    return true;
+}
+
+TransportConnectResult MQTTTransport::pollConnect() {
+    if (_pendingFd < 0) {
+        return TransportConnectResult::FAILED;
+    }
+    
+    fd_set wset;
+    FD_ZERO(&wset);
+    FD_SET(_pendingFd, &wset);
+    struct timeval tv = {0, 0};
+    
+    int res = select(_pendingFd + 1, NULL, &wset, NULL, &tv);
+    if (res == 0) {
+        return TransportConnectResult::PENDING;
+    }
+    
+    int sockErr = 0;
+    socklen_t len = sizeof(sockErr);
+    if (res < 0 || getsockopt(_pendingFd, SOL_SOCKET, SO_ERROR, &sockErr, &len) < 0 || sockErr != 0) {
+        DEBUG_PRINTF("[Transport] TCP connect failed, err=%d\n", res < 0 ? errno : sockErr);
+        closePending();
+        return TransportConnectResult::FAILED;
+    }
+    
+    int fd = _pendingFd;
+    _pendingFd = -1;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    
+    // TLS: soket non-blocking kalır, handshake beginHandshake() ile başlar
+    if (_tls) {
+        _fd = fd;
+        return TransportConnectResult::CONNECTED;
+    }
+    
+    // Bağlantı kuruldu - WiFiClient'ın beklediği blocking moda geri dön
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    _net = WiFiClient(fd);
+    return TransportConnectResult::CONNECTED;
+}
+
+bool MQTTTransport::beginHandshake(const char* host) {
+    if (!_tls || !_tlsConfigured || _fd < 0) {
+        return false;
+    }
+    
+    mbedtls_ssl_init(&_ssl);
+    _sslActive = true;
+    
+    int ret = mbedtls_ssl_setup(&_ssl, &_conf);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_hostname(&_ssl, host);  // SNI + sertifika adı doğrulaması
+    }
+    if (ret != 0) {
+        DEBUG_PRINTF("[Transport] TLS setup failed: -0x%04X\n", -ret);
+        return false;
+    }
+    
+    mbedtls_ssl_set_bio(&_ssl, &_fd, bioSend, bioRecv, NULL);
+    
+    // Önceki bağlantının oturumu varsa sunucuya sun
+    _resumeOffered = _sessionValid && mbedtls_ssl_set_session(&_ssl, &_session) == 0;
+    _handshakeStart = millis();
+    return true;
+}
+
+TransportConnectResult MQTTTransport::pollHandshake() {
+    if (!_sslActive) {
+        return TransportConnectResult::FAILED;
+    }
+    
+    int ret = mbedtls_ssl_handshake(&_ssl);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return TransportConnectResult::PENDING;
+    }
+    
+    if (ret != 0) {
+        DEBUG_PRINTF("[Transport] TLS handshake failed: -0x%04X (verify flags 0x%X)\n",
+                     -ret, mbedtls_ssl_get_verify_result(&_ssl));
+        _stats.failures++;
+        // Sunulan oturum sorunlu olabilir - bir sonraki deneme tam handshake
+        clearSession();
+        return TransportConnectResult::FAILED;
+    }
+    
+    uint32_t elapsed = millis() - _handshakeStart;
+    bool resumed = _resumeOffered && mbedtls_ssl_session_reused(&_ssl);
+    
+    _stats.handshakes++;
+    _stats.lastHandshakeMs = elapsed;
+    _stats.lastResumed = resumed;
+    if (_resumeOffered) {
+        _stats.resumeAttempts++;
+    }
+    if (resumed) {
+        _stats.resumeHits++;
+        _stats.lastResumedMs = elapsed;
+    } else {
+        _stats.lastFullMs = elapsed;
+    }
+    
+    // Bir sonraki bağlantı için oturumu sakla
+    clearSession();
+    _sessionValid = mbedtls_ssl_get_session(&_ssl, &_session) == 0;
+    
+    DEBUG_PRINTF("[Transport] TLS handshake done in %u ms (%s)\n", elapsed, resumed ? "resumed" : "full");
+    
+    _tlsOpen = true;
+    _peerClosed = false;
+    return TransportConnectResult::CONNECTED;
+}
+
+const TlsStats& MQTTTransport::getTlsStats() {
+    return _stats;
+}
+
+void MQTTTransport::injectConnack() {
+    // CONNACK: type 0x20, remaining length 2, session present 0, return code 0
+    _fakeConnack[0] = 0x20;
+    _fakeConnack[1] = 0x02;
+    _fakeConnack[2] = 0x00;
+    _fakeConnack[3] = 0x00;
+    _fakeLen = sizeof(_fakeConnack);
+    _fakePos = 0;
+}
+
+int MQTTTransport::rawAvailable() {
+    return _tls ? tlsAvailable() : _net.available();
+}
+
+int MQTTTransport::rawPeek() {
+    if (!_tls) {
+        return _net.peek();
+    }
+    if (_peekByte < 0) {
+        uint8_t b;
+        if (tlsRead(&b, 1) == 1) {
+            _peekByte = b;
+        }
+    }
+    return _peekByte;
+}
+
+int MQTTTransport::rawRead(uint8_t* buf, size_t size) {
+    return _tls ? tlsRead(buf, size) : _net.read(buf, size);
+}
+
+int MQTTTransport::connect(IPAddress ip, uint16_t port) {
+    // Blocking yol - ThingsBoardMQTT kullanmaz, Client sözleşmesi için
+    closePending();
+    return _net.connect(ip, port);
+}
+
+int MQTTTransport::connect(const char* host, uint16_t port) {
+    closePending();
+    return _net.connect(host, port);
+}
+
+size_t MQTTTransport::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t MQTTTransport::write(const uint8_t* buf, size_t size) {
+    return _tls ? tlsWrite(buf, size) : _net.write(buf, size);
+}
+
+int MQTTTransport::available() {
+    if (_fakePos < _fakeLen) {
+        return _fakeLen - _fakePos;
+    }
+    return rawAvailable();
+}
+
+int MQTTTransport::read() {
+    if (_fakePos < _fakeLen) {
+        return _fakeConnack[_fakePos++];
+    }
+    uint8_t b;
+    return rawRead(&b, 1) == 1 ? b : -1;
+}
+
+int MQTTTransport::read(uint8_t* buf, size_t size) {
+    size_t n = 0;
+    while (_fakePos < _fakeLen && n < size) {
+        buf[n++] = _fakeConnack[_fakePos++];
+    }
+    if (n > 0) {
+        return n;
+    }
+    return rawRead(buf, size);
+}
+
+int MQTTTransport::peek() {
+    if (_fakePos < _fakeLen) {
+        return _fakeConnack[_fakePos];
+    }
+    return rawPeek();
+}
+
+void MQTTTransport::flush() {
+    if (!_tls) {
+        _net.flush();
+    }
+}
+
+void MQTTTransport::stop() {
+    closePending();
+    closeTls();
+    _fakeLen = 0;
+    _fakePos = 0;
+    _net.stop();
+}
+
+int MQTTTransport::socketFd() {
+    return _tls ? _fd : _net.fd();
+}
+
+uint8_t MQTTTransport::connected() {
+    if (_tls) {
+        return _fd >= 0 && _tlsOpen && !_peerClosed;
+    }
+    return _net.connected();
+}
+
+MQTTTransport::operator bool() {
+    return connected();
+}
+
+void MQTTTransport::closePending() {
+    if (_pendingFd >= 0) {
+        close(_pendingFd);
+        _pendingFd = -1;
+    }
+}
+
+// ============================================
+// TLS
+// ============================================
+
+void MQTTTransport::closeTls() {
+    if (_sslActive) {
+        if (_tlsOpen && !_peerClosed) {
+            mbedtls_ssl_close_notify(&_ssl);    // Non-blocking, en iyi çaba
+        }
+        mbedtls_ssl_free(&_ssl);
+        _sslActive = false;
+    }
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _tlsOpen = false;
+    _peerClosed = false;
+    _peekByte = -1;
+    _txLen = 0;
+    _txRetryLen = 0;
+}
+
+void MQTTTransport::clearSession() {
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_session_init(&_session);
+    _sessionValid = false;
+}
+
+int MQTTTransport::tlsAvailable() {
+    if (!_tlsOpen || _peerClosed) {
+        return 0;
+    }
+    
+    int pending = _peekByte >= 0 ? 1 : 0;
+    size_t n = mbedtls_ssl_get_bytes_avail(&_ssl);
+    if (n == 0) {
+        // Soketteki kaydı işle (veri yoksa WANT_READ ile hemen döner)
+        int ret = mbedtls_ssl_read(&_ssl, NULL, 0);
+        if (ret < 0 && tlsFatal(ret)) {
+            return pending;
+        }
+        n = mbedtls_ssl_get_bytes_avail(&_ssl);
+    }
+    return n + pending;
+}
+
+int MQTTTransport::tlsRead(uint8_t* buf, size_t size) {
+    if (size == 0 || !_tlsOpen) {
+        return -1;
+    }
+    
+    size_t n = 0;
+    if (_peekByte >= 0) {
+        buf[n++] = (uint8_t)_peekByte;
+        _peekByte = -1;
+        if (n == size) {
+            return n;
+        }
+    }
+    
+    if (_peerClosed) {
+        return n > 0 ? (int)n : -1;
+    }
+    
+    int ret = mbedtls_ssl_read(&_ssl, buf + n, size - n);
+    if (ret > 0) {
+        return n + ret;
+    }
+    if (ret == 0 || tlsFatal(ret)) {
+        _peerClosed = true;
+    }
+    return n > 0 ? (int)n : -1;
+}
+
+// PubSubClient paketin tamamının yazılmasını bekler. Soket doluysa beklenmez:
+// kalan bekletilir, paket yazılmış sayılır, flushPending() sonra gönderir
+size_t MQTTTransport::tlsWrite(const uint8_t* buf, size_t size) {
+    if (!_tlsOpen || _peerClosed) {
+        return 0;
+    }
+    
+    size_t written = 0;
+    if (flushPending()) {
+        while (written < size) {
+            int ret = mbedtls_ssl_write(&_ssl, buf + written, size - written);
+            if (ret > 0) {
+                written += ret;
+                continue;
+            }
+            if (tlsFatal(ret)) {
+                return written;
+            }
+            _txRetryLen = size - written;
+            break;
+        }
+    }
+    if (_peerClosed || written == size) {
+        return written;
+    }
+    
+    size_t rest = size - written;
+    if (_txLen + rest > sizeof(_txBuf)) {
+        // Yarım paket akışı bozar - bağlantı kapanır, yeniden bağlanılır
+        DEBUG_PRINTF("[Transport] TLS send buffer full (%u bytes pending)\n", (unsigned)_txLen);
+        _peerClosed = true;
+        return written;
+    }
+    memcpy(_txBuf + _txLen, buf + written, rest);
+    _txLen += rest;
+    return size;
+}
+
+bool MQTTTransport::flushPending() {
+    while (_txLen > 0) {
+        if (!_tlsOpen || _peerClosed) {
+            _txLen = 0;
+            _txRetryLen = 0;
+            break;
+        }
+        
+        size_t len = _txRetryLen ? _txRetryLen : _txLen;
+        int ret = mbedtls_ssl_write(&_ssl, _txBuf, len);
+        if (ret > 0) {
+            _txLen -= ret;
+            memmove(_txBuf, _txBuf + ret, _txLen);
+            _txRetryLen = 0;
+            continue;
+        }
+        if (tlsFatal(ret)) {
+            continue;
+        }
+        _txRetryLen = len;
+        return false;
+    }
+    return true;
+}
+
+bool MQTTTransport::writePending() {
+    return _txLen > 0;
+}
+
+bool MQTTTransport::tlsFatal(int ret) {
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return false;
+    }
+    if (ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+        DEBUG_PRINTF("[Transport] TLS error: -0x%04X\n", -ret);
+    }
+    _peerClosed = true;
+    return true;
+}
+
+int MQTTTransport::bioSend(void* ctx, const unsigned char* buf, size_t len) {
+    int fd = *(int*)ctx;
+    int n = send(fd, buf, len, 0);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    return n;
+}
+
+int MQTTTransport::bioRecv(void* ctx, unsigned char* buf, size_t len) {
+    int fd = *(int*)ctx;
+    int n = recv(fd, buf, len, 0);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+    if (n == 0) {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    return n;
+}
+
+int MQTTTransport::tlsRandom(void* ctx, unsigned char* out, size_t len) {
+    // Donanım RNG (WiFi açıkken gerçek entropi)
+    esp_fill_random(out, len);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+#include "Config.h"
+
+// PubSubClient ile soket arasındaki ince katman.
+// - TCP bağlantısı non-blocking olarak kurulur (beginConnect/pollConnect)
+// - Opsiyonel TLS: handshake de non-blocking (beginHandshake/pollHandshake),
+//   oturum bilgisi yeniden bağlanmalarda kullanılır (kısaltılmış handshake)
+// - CONNACK beklemesi PubSubClient'ın içinden çıkarılır: connect() çağrısına
+//   sahte bir CONNACK verilir, gerçeği ThingsBoardMQTT tarafından okunur
+enum class TransportConnectResult {
+    PENDING,
+    CONNECTED,
+    FAILED
+};
+
+struct TlsStats {
+    uint32_t handshakes;        // Başarılı handshake sayısı
+    uint32_t failures;
+    uint32_t resumeAttempts;    // Kayıtlı oturumla denenen handshake'ler
+    uint32_t resumeHits;        // Sunucunun oturumu kabul ettikleri
+    uint32_t lastHandshakeMs;
+    uint32_t lastFullMs;        // Son tam handshake süresi
+    uint32_t lastResumedMs;     // Son kısaltılmış handshake süresi
+    bool lastResumed;
+};
+
+class MQTTTransport : public Client {
+public:
+    MQTTTransport();
+    
+    // TLS ayarı - caPem boşsa yerleşik CA paketi kullanılır.
+    // Kayıtlı oturum silinir (sunucu/CA değişmiş olabilir).
+    bool setTls(bool enabled, const char* caPem);
+    bool isTls();
+    
+    // Non-blocking TCP bağlantısı
+    bool beginConnect(IPAddress ip, uint16_t port);
+    TransportConnectResult pollConnect();
+    
+    // Non-blocking TLS handshake (pollConnect CONNECTED döndükten sonra)
+    bool beginHandshake(const char* host);
+    TransportConnectResult pollHandshake();
+    const TlsStats& getTlsStats();
+    
+    // Bir sonraki okumalarda PubSubClient'a sahte CONNACK ver
+    void injectConnack();
+    
+    // Ham soket erişimi (PubSubClient'ı atlayarak)
+    int rawAvailable();
+    int rawPeek();
+    int rawRead(uint8_t* buf, size_t size);
+    int socketFd();     // Olay döngüsünde select() için, soket yoksa -1
+    
+    // TLS: soket doluyken yazılanlar bekletilir - yeni paket yazmadan önce
+    // flushPending() true dönmeli, false ise soket yazılabilir olunca tekrar
+    bool flushPending();
+    bool writePending();
+    
+    // Client arayüzü
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override;
+
+private:
+    WiFiClient _net;
+    int _pendingFd;
+    
+    uint8_t _fakeConnack[4];
+    uint8_t _fakeLen;
+    uint8_t _fakePos;
+    
+    // TLS modu: soket WiFiClient'a verilmez, mbedTLS üzerinden kullanılır
+    bool _tls;
+    bool _tlsConfigured;
+    int _fd;
+    bool _sslActive;        // _ssl kurulu (handshake sürüyor veya tamam)
+    bool _tlsOpen;          // Handshake tamam
+    bool _peerClosed;
+    int16_t _peekByte;      // TLS'de peek() için okunmuş bayt, yoksa -1
+    unsigned long _handshakeStart;
+    bool _resumeOffered;
+    
+    mbedtls_ssl_context _ssl;
+    mbedtls_ssl_config _conf;
+    mbedtls_x509_crt _ca;
+    mbedtls_ssl_session _session;
+    bool _sessionValid;
+    TlsStats _stats;
+    
+    // WANT_WRITE sonrası mbedtls_ssl_write aynı argümanlarla tekrar çağrılmalı:
+    // _txRetryLen, bekleyen verinin başındaki o çağrının uzunluğu
+    uint8_t _txBuf[MQTT_TLS_TX_PENDING];
+    size_t _txLen;
+    size_t _txRetryLen;
+    
+    void closePending();
+    void closeTls();
+    void clearSession();
+    int tlsAvailable();
+    int tlsRead(uint8_t* buf, size_t size);
+    size_t tlsWrite(const uint8_t* buf, size_t size);
+    bool tlsFatal(int ret);
+    
+    static int bioSend(void* ctx, const unsigned char* buf, size_t len);
+    static int bioRecv(void* ctx, unsigned char* buf, size_t len);
+    static int tlsRandom(void* ctx, unsigned char* out, size_t len);
+};
+
+#endif // MQTT_TRANSPORT_H
@@ -0,0 +1,274 @@
+#include "ModbusMaster.h"
+#include "ThingsBoardMQTT.h"
+#include "TelemetryQueue.h"
+#include "EventLoop.h"
+
+static_assert(MODBUS_MAX_POINTS <= 32, "validMask holds at most 32 points");
+
+ModbusMaster Gateway;
+
+ModbusMaster::ModbusMaster() {
+    _pointCount = 0;
+    _blockCount = 0;
+    _uartQueue = nullptr;
+    _task = nullptr;
+    _requests = 0;
+    _errors = 0;
+    _droppedCycles = 0;
+}
+
+bool ModbusMaster::addPoint(const ModbusPoint& point) {
+    if (_task != nullptr || _pointCount >= MODBUS_MAX_POINTS) {
+        DEBUG_PRINTF("[Modbus] Cannot add point %s/%s\n", point.device, point.key);
+        return false;
+    }
+    _points[_pointCount++] = point;
+    return true;
+}
+
+void ModbusMaster::begin() {
+    if (_pointCount == 0) {
+        DEBUG_PRINTLN("[Modbus] Poll table empty, master disabled");
+        return;
+    }
+    
+    sortPoints();
+    buildBlocks();
+    
+    if (!modbusUartBegin(&_uartQueue)) {
+        return;
+    }
+    
+    xTaskCreatePinnedToCore(taskEntry, "modbus", MODBUS_TASK_STACK, this,
+                            MODBUS_TASK_PRIORITY, &_task, MODBUS_TASK_CORE);
+    
+    DEBUG_PRINTF("[Modbus] Master started: %u points in %u requests\n", _pointCount, _blockCount);
+}
+
+void ModbusMaster::loop() {
+    // RPC yanıtları ve röle telemetry'si önce
+    if (!TB.outboxIdle()) {
+        return;
+    }
+    
+    if (!_cycles.pop(_sending) || _sending.validMask == 0) {
+        return;
+    }
+    
+    if (TB.publishStream(TB_GATEWAY_TELEMETRY_TOPIC, writeGatewayJson, this)) {
+        DEBUG_PRINTLN("[Modbus] Gateway telemetry sent");
+    } else {
+        DEBUG_PRINTLN("[Modbus] Gateway telemetry send failed");
+    }
+}
+
+uint32_t ModbusMaster::getRequestCount() {
+    return _requests;
+}
+
+uint32_t ModbusMaster::getErrorCount() {
+    return _errors;
+}
+
+// Cihaz, slave, fonksiyon, adres sırası: aynı cihazın noktaları JSON'da bir arada,
+// aynı slave/fonksiyonun bitişik register'ları tek blokta
+void ModbusMaster::sortPoints() {
+    for (size_t i = 1; i < _pointCount; i++) {
+        ModbusPoint p = _points[i];
+        size_t j = i;
+        while (j > 0) {
+            const ModbusPoint& q = _points[j - 1];
+            int cmp = strcmp(q.device, p.device);
+            if (cmp == 0) cmp = (int)q.slaveId - (int)p.slaveId;
+            if (cmp == 0) cmp = (int)q.function - (int)p.function;
+            if (cmp == 0) cmp = (int)q.address - (int)p.address;
+            if (cmp <= 0) break;
+            _points[j] = q;
+            j--;
+        }
+        _points[j] = p;
+    }
+}
+
+void ModbusMaster::buildBlocks() {
+    _blockCount = 0;
+    Block* block = nullptr;
+    
+    for (size_t i = 0; i < _pointCount; i++) {
+        const ModbusPoint& p = _points[i];
+        uint16_t end = p.address + registerCount(p.type);
+        
+        if (block != nullptr && block->slaveId == p.slaveId && block->function == p.function &&
+            p.address <= block->start + block->count + MODBUS_MAX_GAP_REGS &&
+            end - block->start <= MODBUS_MAX_BLOCK_REGS) {
+            if (end > block->start + block->count) {
+                block->count = end - block->start;
+            }
+            block->pointCount++;
+            continue;
+        }
+        
+        block = &_blocks[_blockCount++];
+        block->slaveId = p.slaveId;
+        block->function = p.function;
+        block->start = p.address;
+        block->count = end - p.address;
+        block->firstPoint = i;
+        block->pointCount = 1;
+    }
+    
+    // İstek çerçeveleri bir kez hazırlanır
+    for (size_t b = 0; b < _blockCount; b++) {
+        Block& blk = _blocks[b];
+        blk.request[0] = blk.slaveId;
+        blk.request[1] = blk.function;
+        blk.request[2] = blk.start >> 8;
+        blk.request[3] = blk.start & 0xFF;
+        blk.request[4] = blk.count >> 8;
+        blk.request[5] = blk.count & 0xFF;
+        modbusAppendCrc(blk.request, 6);
+    }
+}
+
+void ModbusMaster::taskEntry(void* arg) {
+    static_cast<ModbusMaster*>(arg)->run();
+}
+
+void ModbusMaster::run() {
+    TickType_t lastWake = xTaskGetTickCount();
+    
+    for (;;) {
+        pollCycle();
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(MODBUS_POLL_INTERVAL_MS));
+    }
+}
+
+// Pipelining: bir sonraki istek UART'a verildikten sonra, o hatta giderken
+// önceki yanıt çözülür. Çerçeve sonu ve araları UART donanımında.
+void ModbusMaster::pollCycle() {
+    _current.validMask = 0;
+    int pendingBlock = -1;
+    uint8_t rxIdx = 0;
+    
+    for (size_t b = 0; b < _blockCount; b++) {
+        const Block& block = _blocks[b];
+        
+        // Geç gelen önceki yanıtları at
+        uart_flush_input(MODBUS_UART_NUM);
+        xQueueReset(_uartQueue);
+        uart_write_bytes(MODBUS_UART_NUM, block.request, sizeof(block.request));
+        _requests++;
+        
+        if (pendingBlock >= 0) {
+            decode(_blocks[pendingBlock], _rx[rxIdx ^ 1]);
+            pendingBlock = -1;
+        }
+        
+        int len = modbusReadFrame(_uartQueue, _rx[rxIdx], MODBUS_MAX_FRAME,
+                                  pdMS_TO_TICKS(MODBUS_RESPONSE_TIMEOUT_MS));
+        if (!validate(block, _rx[rxIdx], len)) {
+            _errors++;
+            continue;
+        }
+        
+        pendingBlock = b;
+        rxIdx ^= 1;
+    }
+    
+    if (pendingBlock >= 0) {
+        decode(_blocks[pendingBlock], _rx[rxIdx ^ 1]);
+    }
+    
+    _current.ts = TelemetryQueue::timeValid() ? TelemetryQueue::epochMs() : 0;
+    if (!_cycles.push(_current)) {
+        _droppedCycles++;   // Ağ task'ı yetişemedi (bağlantı yok)
+    }
+    Events.wake();
+}
+
+bool ModbusMaster::validate(const Block& block, const uint8_t* frame, int len) {
+    if (len < 5) {
+        DEBUG_PRINTF("[Modbus] Slave %d: no response\n", block.slaveId);
+        return false;
+    }
+    if (!modbusCheckCrc(frame, len)) {
+        DEBUG_PRINTF("[Modbus] Slave %d: CRC error\n", block.slaveId);
+        return false;
+    }
+    if (frame[0] != block.slaveId) {
+        return false;
+    }
+    if (frame[1] == (block.function | 0x80)) {
+        DEBUG_PRINTF("[Modbus] Slave %d: exception %d\n", block.slaveId, frame[2]);
+        return false;
+    }
+    return frame[1] == block.function && frame[2] == block.count * 2 && len == 5 + block.count * 2;
+}
+
+void ModbusMaster::decode(const Block& block, const uint8_t* frame) {
+    const uint8_t* data = frame + 3;
+    
+    for (uint8_t i = 0; i < block.pointCount; i++) {
+        size_t idx = block.firstPoint + i;
+        const ModbusPoint& p = _points[idx];
+        const uint8_t* d = data + (p.address - block.start) * 2;
+        
+        uint32_t raw = ((uint32_t)d[0] << 8) | d[1];
+        if (registerCount(p.type) == 2) {
+            raw = (raw << 16) | ((uint32_t)d[2] << 8) | d[3];
+        }
+        
+        float value;
+        switch (p.type) {
+            case ModbusType::U16: value = (uint16_t)raw; break;
+            case ModbusType::S16: value = (int16_t)raw; break;
+            case ModbusType::U32: value = raw; break;
+            case ModbusType::S32: value = (int32_t)raw; break;
+            case ModbusType::F32: memcpy(&value, &raw, sizeof(value)); break;
+            default: value = 0; break;
+        }
+        
+        _current.values[idx] = value * p.scale;
+        _current.validMask |= (1UL << idx);
+    }
+}
+
+// {"Meter-1":[{"ts":1718000000000,"values":{"voltage":230.1,"current":1.25}}], ...}
+void ModbusMaster::writeGatewayJson(JsonWriter& json, void* ctx) {
+    const ModbusMaster* self = static_cast<const ModbusMaster*>(ctx);
+    const Cycle& cycle = self->_sending;
+    const ModbusPoint* points = self->_points;
+    const char* device = nullptr;
+    
+    json.beginObject();
+    for (size_t i = 0; i < self->_pointCount; i++) {
+        if (!(cycle.validMask & (1UL << i))) continue;
+        const ModbusPoint& p = points[i];
+        
+        if (device == nullptr || strcmp(device, p.device) != 0) {
+            if (device != nullptr) {
+                json.endObject();
+                json.endObject();
+                json.endArray();
+            }
+            json.beginArray(p.device);
+            json.beginObject();
+            if (cycle.ts != 0) {
+                json.add("ts", (unsigned long long)cycle.ts);
+            }
+            json.beginObject("values");
+            device = p.device;
+        }
+        json.add(p.key, cycle.values[i], 3);
+    }
+    if (device != nullptr) {
+        json.endObject();
+        json.endObject();
+        json.endArray();
+    }
+    json.endObject();
+}
+
+uint8_t ModbusMaster::registerCount(ModbusType type) {
+    return (type == ModbusType::U16 || type == ModbusType::S16) ? 1 : 2;
+}
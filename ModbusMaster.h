@@ -0,0 +1,97 @@
+#ifndef MODBUS_MASTER_H
+#define MODBUS_MASTER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "Config.h"
+#include "ModbusRTU.h"
+#include "JsonWriter.h"
+#include "SpscQueue.h"
+
+// RS485 üzerindeki sayaçları okuyan Modbus RTU master.
+// Poll tablosundaki noktalar (slave, fonksiyon) bazında bitişik register
+// bloklarına birleştirilir; her çevrim ThingsBoard gateway API'sine tek mesaj olur.
+
+enum class ModbusType : uint8_t {
+    U16,
+    S16,
+    U32,    // İki register, yüksek word önce
+    S32,
+    F32     // IEEE754, yüksek word önce
+};
+
+struct ModbusPoint {
+    const char* device;     // ThingsBoard'daki alt cihaz adı (gateway üzerinden)
+    const char* key;        // Telemetry anahtarı
+    uint8_t slaveId;
+    uint8_t function;       // MODBUS_FC_READ_HOLDING / MODBUS_FC_READ_INPUT
+    uint16_t address;
+    ModbusType type;
+    float scale;            // Ham değer çarpanı
+};
+
+class ModbusMaster {
+public:
+    ModbusMaster();
+    
+    // begin()'den önce çağrılmalı; device/key kalıcı olmalı (string literal)
+    bool addPoint(const ModbusPoint& point);
+    
+    void begin();   // UART + poll task'ı
+    void loop();    // Ağ task'ı: tamamlanan çevrimi gateway telemetry olarak gönderir
+    
+    uint32_t getRequestCount();
+    uint32_t getErrorCount();
+
+private:
+    // Tek istekle okunan register aralığı ve kapsadığı noktalar
+    struct Block {
+        uint8_t slaveId;
+        uint8_t function;
+        uint16_t start;
+        uint16_t count;
+        uint8_t firstPoint;
+        uint8_t pointCount;
+        uint8_t request[8];     // Önceden hazırlanmış istek çerçevesi (CRC dahil)
+    };
+    
+    // Bir poll çevriminin sonucu
+    struct Cycle {
+        uint64_t ts;            // Epoch ms, saat senkron değilse 0
+        uint32_t validMask;     // Bit i: _points[i] okundu
+        float values[MODBUS_MAX_POINTS];
+    };
+    
+    ModbusPoint _points[MODBUS_MAX_POINTS];
+    size_t _pointCount;
+    Block _blocks[MODBUS_MAX_POINTS];
+    size_t _blockCount;
+    
+    QueueHandle_t _uartQueue;
+    TaskHandle_t _task;
+    
+    Cycle _current;                         // Poll task'ı doldurur
+    SpscQueue<Cycle, 2> _cycles;            // Poll task'ı -> ağ task'ı
+    uint8_t _rx[2][MODBUS_MAX_FRAME];       // Pipelining: biri çözülürken diğeri alınır
+    Cycle _sending;                         // Ağ task'ında akışla gönderilen çevrim
+    
+    volatile uint32_t _requests;
+    volatile uint32_t _errors;
+    volatile uint32_t _droppedCycles;
+    
+    void sortPoints();
+    void buildBlocks();
+    void run();
+    void pollCycle();
+    bool validate(const Block& block, const uint8_t* frame, int len);
+    void decode(const Block& block, const uint8_t* frame);
+    static void writeGatewayJson(JsonWriter& json, void* ctx);
+    static uint8_t registerCount(ModbusType type);
+    static void taskEntry(void* arg);
+};
+
+extern ModbusMaster Gateway;
+
+#endif // MODBUS_MASTER_H
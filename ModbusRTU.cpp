@@ -0,0 +1,106 @@
+#include "ModbusRTU.h"
+#include <freertos/task.h>
+
+uint16_t modbusCrc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+size_t modbusAppendCrc(uint8_t* frame, size_t len) {
+    uint16_t crc = modbusCrc16(frame, len);
+    frame[len] = crc & 0xFF;        // Önce düşük bayt
+    frame[len + 1] = crc >> 8;
+    return len + 2;
+}
+
+bool modbusCheckCrc(const uint8_t* frame, size_t len) {
+    if (len < 4) return false;
+    uint16_t crc = modbusCrc16(frame, len - 2);
+    return frame[len - 2] == (crc & 0xFF) && frame[len - 1] == (crc >> 8);
+}
+
+bool modbusUartBegin(QueueHandle_t* eventQueue) {
+    uart_config_t cfg = {};
+    cfg.baud_rate = MODBUS_BAUD;
+    cfg.data_bits = UART_DATA_8_BITS;
+    cfg.parity = MODBUS_PARITY_EVEN ? UART_PARITY_EVEN : UART_PARITY_DISABLE;
+    cfg.stop_bits = UART_STOP_BITS_1;
+    cfg.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    cfg.source_clk = UART_SCLK_DEFAULT;
+    
+    esp_err_t err = uart_driver_install(MODBUS_UART_NUM, MODBUS_UART_BUFFER * 2, MODBUS_UART_BUFFER,
+                                        16, eventQueue, 0);
+    if (err == ESP_OK) err = uart_param_config(MODBUS_UART_NUM, &cfg);
+    if (err == ESP_OK) err = uart_set_pin(MODBUS_UART_NUM, GPIO_RS485_TX, GPIO_RS485_RX,
+                                          GPIO_RS485_DE, UART_PIN_NO_CHANGE);
+    if (err == ESP_OK) err = uart_set_mode(MODBUS_UART_NUM,
+                                           GPIO_RS485_DE >= 0 ? UART_MODE_RS485_HALF_DUPLEX : UART_MODE_UART);
+    
+    // Çerçeve sonu: hat bu kadar sembol sessiz kalınca timeout_flag'li UART_DATA olayı
+    if (err == ESP_OK) err = uart_set_rx_timeout(MODBUS_UART_NUM, MODBUS_RX_TIMEOUT_SYMBOLS);
+    // Ardışık gönderimler arasında donanım 3.5 karakter boşluk bırakır
+    if (err == ESP_OK) err = uart_set_tx_idle_num(MODBUS_UART_NUM, MODBUS_FRAME_GAP_BITS);
+    
+    if (err != ESP_OK) {
+        DEBUG_PRINTF("[Modbus] UART setup failed: %s\n", esp_err_to_name(err));
+        return false;
+    }
+    
+    DEBUG_PRINTF("[Modbus] UART%d ready, %d baud, TX=%d RX=%d\n",
+                 MODBUS_UART_NUM, MODBUS_BAUD, GPIO_RS485_TX, GPIO_RS485_RX);
+    return true;
+}
+
+int modbusReadFrame(QueueHandle_t eventQueue, uint8_t* buf, size_t size, TickType_t timeout) {
+    size_t len = 0;
+    bool failed = false;
+    TickType_t start = xTaskGetTickCount();
+    uart_event_t event;
+    
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        if (timeout != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            wait = elapsed >= timeout ? 0 : timeout - elapsed;
+        }
+        
+        if (xQueueReceive(eventQueue, &event, wait) != pdTRUE) {
+            return -1;  // Zaman aşımı
+        }
+        
+        switch (event.type) {
+            case UART_DATA:
+                if (event.size > size - len) {
+                    failed = true;  // Çerçeve tampondan büyük - sonuna kadar at
+                    uart_flush_input(MODBUS_UART_NUM);
+                } else if (event.size > 0) {
+                    len += uart_read_bytes(MODBUS_UART_NUM, buf + len, event.size, 0);
+                }
+                // RX timeout: hat sessiz, çerçeve tamam
+                if (event.timeout_flag) {
+                    return failed ? -1 : (int)len;
+                }
+                break;
+            
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                uart_flush_input(MODBUS_UART_NUM);
+                xQueueReset(eventQueue);
+                return -1;
+            
+            case UART_FRAME_ERR:
+            case UART_PARITY_ERR:
+                failed = true;
+                break;
+            
+            default:
+                break;
+        }
+    }
+}
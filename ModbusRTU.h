@@ -0,0 +1,40 @@
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include "Config.h"
+
+// Modbus RTU ortak parçaları: CRC, RS485 UART kurulumu ve çerçeve okuma.
+// Çerçeve sınırları yazılım zamanlayıcısıyla değil UART donanımıyla belirlenir:
+// RX timeout hattın sessiz kaldığını bildirir, TX idle çerçeve arası boşluğu korur.
+
+#define MODBUS_FC_READ_COILS            0x01
+#define MODBUS_FC_READ_HOLDING          0x03
+#define MODBUS_FC_READ_INPUT            0x04
+#define MODBUS_FC_WRITE_COIL            0x05
+#define MODBUS_FC_WRITE_COILS           0x0F
+
+#define MODBUS_EX_ILLEGAL_FUNCTION      0x01
+#define MODBUS_EX_ILLEGAL_ADDRESS       0x02
+#define MODBUS_EX_ILLEGAL_VALUE         0x03
+#define MODBUS_EX_DEVICE_FAILURE        0x04
+
+#define MODBUS_MAX_FRAME                256
+
+uint16_t modbusCrc16(const uint8_t* data, size_t len);
+
+// CRC'yi frame[len], frame[len+1]'e ekler, yeni uzunluğu döner
+size_t modbusAppendCrc(uint8_t* frame, size_t len);
+bool modbusCheckCrc(const uint8_t* frame, size_t len);
+
+// UART sürücüsünü RS485 ayarlarıyla kurar, olay kuyruğunu döner
+bool modbusUartBegin(QueueHandle_t* eventQueue);
+
+// Bir çerçeveyi (RX timeout'a kadar gelen baytlar) okur.
+// Dönüş: uzunluk, zaman aşımı / taşma / hat hatasında -1
+int modbusReadFrame(QueueHandle_t eventQueue, uint8_t* buf, size_t size, TickType_t timeout);
+
+#endif // MODBUS_RTU_H
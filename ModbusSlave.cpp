@@ -0,0 +1,194 @@
+#include "ModbusSlave.h"
+#include <WiFi.h>
+#include "RelayActuator.h"
+#include "ThingsBoardMQTT.h"
+
+ModbusSlave LocalModbus;
+
+ModbusSlave::ModbusSlave() {
+    _uartQueue = nullptr;
+    _task = nullptr;
+    _frames = 0;
+    _errors = 0;
+}
+
+void ModbusSlave::begin() {
+    if (!modbusUartBegin(&_uartQueue)) {
+        return;
+    }
+    
+    xTaskCreatePinnedToCore(taskEntry, "modbus_slave", MODBUS_TASK_STACK, this,
+                            MODBUS_SLAVE_TASK_PRIORITY, &_task, MODBUS_TASK_CORE);
+    
+    DEBUG_PRINTF("[Modbus] Slave started, address %d\n", MODBUS_SLAVE_ID);
+}
+
+uint32_t ModbusSlave::getFrameCount() {
+    return _frames;
+}
+
+uint32_t ModbusSlave::getErrorCount() {
+    return _errors;
+}
+
+void ModbusSlave::taskEntry(void* arg) {
+    static_cast<ModbusSlave*>(arg)->run();
+}
+
+void ModbusSlave::run() {
+    for (;;) {
+        // UART olayına kadar uyur; çerçeve sonu RX timeout ile (donanım)
+        int len = modbusReadFrame(_uartQueue, _rx, sizeof(_rx), portMAX_DELAY);
+        if (len < 4) {
+            continue;
+        }
+        if (!modbusCheckCrc(_rx, len)) {
+            _errors++;
+            continue;   // Bozuk çerçeveye yanıt verilmez
+        }
+        
+        handleFrame(_rx, len - 2);
+    }
+}
+
+void ModbusSlave::handleFrame(const uint8_t* frame, size_t len) {
+    uint8_t address = frame[0];
+    bool broadcast = address == 0;
+    if (address != MODBUS_SLAVE_ID && !broadcast) {
+        return;     // Başka slave'e
+    }
+    
+    _frames++;
+    uint8_t function = frame[1];
+    const uint8_t* pdu = frame + 1;
+    size_t pduLen = len - 1;
+    int result;
+    
+    switch (function) {
+        case MODBUS_FC_READ_COILS:
+            result = readCoils(pdu, pduLen);
+            break;
+        case MODBUS_FC_WRITE_COIL:
+            result = writeCoil(pdu, pduLen);
+            break;
+        case MODBUS_FC_WRITE_COILS:
+            result = writeCoils(pdu, pduLen);
+            break;
+        case MODBUS_FC_READ_INPUT:
+            result = readInputRegisters(pdu, pduLen);
+            break;
+        default:
+            result = -MODBUS_EX_ILLEGAL_FUNCTION;
+            break;
+    }
+    
+    // Broadcast yazmalar uygulanır ama yanıtlanmaz
+    if (broadcast) {
+        return;
+    }
+    
+    if (result < 0) {
+        _errors++;
+        sendException(function, -result);
+    } else {
+        sendResponse(result);
+    }
+}
+
+// İstek: fn, start(2), count(2)  Yanıt: fn, byteCount, coil bitleri
+int ModbusSlave::readCoils(const uint8_t* pdu, size_t len) {
+    if (len != 5) return -MODBUS_EX_ILLEGAL_VALUE;
+    uint16_t start = (pdu[1] << 8) | pdu[2];
+    uint16_t count = (pdu[3] << 8) | pdu[4];
+    
+    if (count == 0 || count > RELAY_COUNT) return -MODBUS_EX_ILLEGAL_VALUE;
+    if (start + count > RELAY_COUNT) return -MODBUS_EX_ILLEGAL_ADDRESS;
+    
+    _tx[1] = MODBUS_FC_READ_COILS;
+    _tx[2] = 1;
+    _tx[3] = (Relays.getStatesBitmask() >> start) & ((1 << count) - 1);
+    return 4;
+}
+
+// İstek: fn, address(2), value(2) (0xFF00 açık, 0x0000 kapalı)  Yanıt: isteğin aynısı
+int ModbusSlave::writeCoil(const uint8_t* pdu, size_t len) {
+    if (len != 5) return -MODBUS_EX_ILLEGAL_VALUE;
+    uint16_t address = (pdu[1] << 8) | pdu[2];
+    uint16_t value = (pdu[3] << 8) | pdu[4];
+    
+    if (value != 0xFF00 && value != 0x0000) return -MODBUS_EX_ILLEGAL_VALUE;
+    if (address >= RELAY_COUNT) return -MODBUS_EX_ILLEGAL_ADDRESS;
+    
+    if (!Actuator.setState(RelaySource::MODBUS, address + 1, value == 0xFF00)) {
+        return -MODBUS_EX_DEVICE_FAILURE;
+    }
+    
+    memcpy(_tx + 1, pdu, 5);
+    return 6;
+}
+
+// İstek: fn, start(2), count(2), byteCount, bitler  Yanıt: fn, start(2), count(2)
+int ModbusSlave::writeCoils(const uint8_t* pdu, size_t len) {
+    if (len < 7) return -MODBUS_EX_ILLEGAL_VALUE;
+    uint16_t start = (pdu[1] << 8) | pdu[2];
+    uint16_t count = (pdu[3] << 8) | pdu[4];
+    uint8_t byteCount = pdu[5];
+    
+    if (count == 0 || count > RELAY_COUNT || byteCount != 1 || len != 7) return -MODBUS_EX_ILLEGAL_VALUE;
+    if (start + count > RELAY_COUNT) return -MODBUS_EX_ILLEGAL_ADDRESS;
+    
+    // Tek komut: tüm kanallar aynı anda anahtarlanır
+    uint8_t mask = ((1 << count) - 1) << start;
+    uint8_t states = (pdu[6] << start) & mask;
+    if (!Actuator.setMask(RelaySource::MODBUS, mask, states)) {
+        return -MODBUS_EX_DEVICE_FAILURE;
+    }
+    
+    memcpy(_tx + 1, pdu, 5);
+    return 6;
+}
+
+// İstek: fn, start(2), count(2)  Yanıt: fn, byteCount, register'lar
+int ModbusSlave::readInputRegisters(const uint8_t* pdu, size_t len) {
+    if (len != 5) return -MODBUS_EX_ILLEGAL_VALUE;
+    uint16_t start = (pdu[1] << 8) | pdu[2];
+    uint16_t count = (pdu[3] << 8) | pdu[4];
+    
+    if (count == 0 || count > MODBUS_IREG_COUNT) return -MODBUS_EX_ILLEGAL_VALUE;
+    if (start + count > MODBUS_IREG_COUNT) return -MODBUS_EX_ILLEGAL_ADDRESS;
+    
+    _tx[1] = MODBUS_FC_READ_INPUT;
+    _tx[2] = count * 2;
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t value = inputRegister(start + i);
+        _tx[3 + i * 2] = value >> 8;
+        _tx[4 + i * 2] = value & 0xFF;
+    }
+    return 3 + count * 2;
+}
+
+uint16_t ModbusSlave::inputRegister(uint16_t address) {
+    uint32_t uptime = millis() / 1000;
+    
+    switch (address) {
+        case MODBUS_IREG_RELAY_STATES:  return Relays.getStatesBitmask();
+        case MODBUS_IREG_UPTIME_LO:     return uptime & 0xFFFF;
+        case MODBUS_IREG_UPTIME_HI:     return uptime >> 16;
+        case MODBUS_IREG_RSSI:          return WiFi.status() == WL_CONNECTED ? (uint16_t)(int16_t)WiFi.RSSI() : 0;
+        case MODBUS_IREG_CLOUD:         return TB.getConnState() == MQTTConnState::CONNECTED ? 1 : 0;
+        case MODBUS_IREG_FREE_HEAP_KB:  return ESP.getFreeHeap() / 1024;
+        default:                        return 0;
+    }
+}
+
+void ModbusSlave::sendResponse(size_t len) {
+    _tx[0] = MODBUS_SLAVE_ID;
+    len = modbusAppendCrc(_tx, len);
+    uart_write_bytes(MODBUS_UART_NUM, _tx, len);
+}
+
+void ModbusSlave::sendException(uint8_t function, uint8_t code) {
+    _tx[1] = function | 0x80;
+    _tx[2] = code;
+    sendResponse(3);
+}
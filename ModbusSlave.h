@@ -0,0 +1,61 @@
+#ifndef MODBUS_SLAVE_H
+#define MODBUS_SLAVE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "Config.h"
+#include "ModbusRTU.h"
+
+// Röleleri RS485 üzerinden yerel bir master'a (PLC) açan Modbus RTU slave.
+// UART olaylarıyla uyanan kendi task'ında çalışır; WiFi / ThingsBoard
+// durumundan bağımsızdır. Komutlar RelayActuator'a gider, bu yüzden
+// durum değişiklikleri telemetry'ye her zamanki yoldan ulaşır.
+//
+// Coil'ler (FC 01 / 05 / 15):   0..5 -> relay1..relay6
+// Input register'lar (FC 04):
+#define MODBUS_IREG_RELAY_STATES    0   // Röle bitmask'i
+#define MODBUS_IREG_UPTIME_LO       1   // Uptime (s), düşük word
+#define MODBUS_IREG_UPTIME_HI       2   // Uptime (s), yüksek word
+#define MODBUS_IREG_RSSI            3   // dBm (signed), WiFi yoksa 0
+#define MODBUS_IREG_CLOUD           4   // 1: ThingsBoard bağlı
+#define MODBUS_IREG_FREE_HEAP_KB    5
+#define MODBUS_IREG_COUNT           6
+
+class ModbusSlave {
+public:
+    ModbusSlave();
+    
+    void begin();
+    
+    uint32_t getFrameCount();
+    uint32_t getErrorCount();
+
+private:
+    QueueHandle_t _uartQueue;
+    TaskHandle_t _task;
+    uint8_t _rx[MODBUS_MAX_FRAME];
+    uint8_t _tx[MODBUS_MAX_FRAME];
+    
+    volatile uint32_t _frames;
+    volatile uint32_t _errors;
+    
+    void run();
+    void handleFrame(const uint8_t* frame, size_t len);
+    
+    // Yanıt uzunluğu (CRC hariç) veya exception kodu (negatif)
+    int readCoils(const uint8_t* pdu, size_t len);
+    int writeCoil(const uint8_t* pdu, size_t len);
+    int writeCoils(const uint8_t* pdu, size_t len);
+    int readInputRegisters(const uint8_t* pdu, size_t len);
+    uint16_t inputRegister(uint16_t address);
+    
+    void sendResponse(size_t len);
+    void sendException(uint8_t function, uint8_t code);
+    static void taskEntry(void* arg);
+};
+
+extern ModbusSlave LocalModbus;
+
+#endif // MODBUS_SLAVE_H
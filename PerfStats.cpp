@@ -0,0 +1,174 @@
+#include "PerfStats.h"
+#include "EventLoop.h"
+#include "ThingsBoardMQTT.h"
+
+PerfStats Perf;
+
+static const char* const PROBE_NAMES[] = {
+    "loop_period",
+    "loop_busy",
+    "loop_late",
+    "state_boot",
+    "state_ap",
+    "state_wifi",
+    "state_mqtt",
+    "state_connected",
+    "state_error",
+    "tb_loop",
+    "ota_loop",
+    "led_update",
+    "rpc_dispatch"
+};
+
+static_assert(sizeof(PROBE_NAMES) / sizeof(PROBE_NAMES[0]) == (size_t)PerfProbe::COUNT, "PROBE_NAMES must match PerfProbe");
+static_assert(PERF_BUCKETS >= 2 && PERF_BUCKETS <= 32, "PERF_BUCKETS must be 2..32");
+
+PerfStats::PerfStats() {
+    memset(_hist, 0, sizeof(_hist));
+    _lastReport = 0;
+    _reportPending = false;
+}
+
+void PerfStats::begin() {
+    if (!PERF_ENABLED) return;
+    
+    _lastReport = millis();
+    TB.registerRpc(RPC_METHOD("getPerfStats"), rpcGetPerfStats);
+}
+
+void PerfStats::loop() {
+    if (!PERF_ENABLED) return;
+    
+#if PERF_TELEMETRY_INTERVAL_MS > 0
+    if (millis() - _lastReport >= PERF_TELEMETRY_INTERVAL_MS) {
+        _reportPending = true;
+    } else {
+        Events.dueAt(_lastReport + PERF_TELEMETRY_INTERVAL_MS);
+    }
+#endif
+
+    // RPC yanıtları ve röle telemetry'si önce
+    if (!_reportPending || !TB.outboxIdle()) return;
+    
+    _reportPending = false;
+    _lastReport = millis();
+    if (!TB.publishStream(TB_TELEMETRY_TOPIC, writeReport, this)) {
+        _reportPending = true;
+    }
+}
+
+void PerfStats::record(PerfProbe probe, int64_t startUs) {
+    int64_t elapsed = now() - startUs;
+    add(probe, elapsed > 0 ? (uint32_t)min(elapsed, (int64_t)UINT32_MAX) : 0);
+}
+
+void PerfStats::add(PerfProbe probe, uint32_t us) {
+    if (!PERF_ENABLED) return;
+    
+    Histogram& h = _hist[(size_t)probe];
+    size_t bucket = us < 2 ? 0 : 31 - __builtin_clz(us);
+    if (bucket >= PERF_BUCKETS) {
+        bucket = PERF_BUCKETS - 1;
+    }
+    
+    h.buckets[bucket]++;
+    h.count++;
+    h.total += us;
+    if (us > h.max) {
+        h.max = us;
+    }
+}
+
+void PerfStats::reset() {
+    memset(_hist, 0, sizeof(_hist));
+}
+
+uint32_t PerfStats::percentile(PerfProbe probe, uint8_t pct) {
+    const Histogram& h = _hist[(size_t)probe];
+    if (h.count == 0) return 0;
+    
+    // Sıradaki örneği içeren kovanın üst sınırı - gerçek değerin en fazla 2 katı
+    uint32_t rank = ((uint64_t)h.count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < PERF_BUCKETS - 1; i++) {
+        seen += h.buckets[i];
+        if (seen >= rank) {
+            return min((2u << i) - 1, h.max);
+        }
+    }
+    return h.max;
+}
+
+// {"n":1520,"mean":412,"p50":511,"p99":4095,"max":3870} (µs)
+void PerfStats::writeProbe(JsonWriter& json, PerfProbe probe) {
+    const Histogram& h = _hist[(size_t)probe];
+    json.add("n", (unsigned long)h.count);
+    json.add("mean", (unsigned long)(h.count ? h.total / h.count : 0));
+    json.add("p50", (unsigned long)percentile(probe, 50));
+    json.add("p99", (unsigned long)percentile(probe, 99));
+    json.add("max", (unsigned long)h.max);
+}
+
+int8_t PerfStats::probeByName(const char* name) {
+    for (size_t i = 0; i < (size_t)PerfProbe::COUNT; i++) {
+        if (strcmp(PROBE_NAMES[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Düz anahtarlar (grafik için): {"perf_tb_loop_n":1520,"perf_tb_loop_p50":511,...}
+void PerfStats::writeReport(JsonWriter& json, void* ctx) {
+    PerfStats* self = static_cast<PerfStats*>(ctx);
+    char key[40];
+    
+    json.beginObject();
+    for (size_t i = 0; i < (size_t)PerfProbe::COUNT; i++) {
+        PerfProbe probe = (PerfProbe)i;
+        const Histogram& h = self->_hist[i];
+        if (h.count == 0) continue;
+        
+        snprintf(key, sizeof(key), "perf_%s_n", PROBE_NAMES[i]);
+        json.add(key, (unsigned long)h.count);
+        snprintf(key, sizeof(key), "perf_%s_p50", PROBE_NAMES[i]);
+        json.add(key, (unsigned long)self->percentile(probe, 50));
+        snprintf(key, sizeof(key), "perf_%s_p99", PROBE_NAMES[i]);
+        json.add(key, (unsigned long)self->percentile(probe, 99));
+        snprintf(key, sizeof(key), "perf_%s_max", PROBE_NAMES[i]);
+        json.add(key, (unsigned long)h.max);
+    }
+    json.endObject();
+}
+
+// {"probe":"tb_loop"}: tek ölçüm noktası yanıtta.
+// Parametresiz: özet yanıtta, tüm histogramlar "perf_*" telemetry'si olarak.
+// {"reset":true}: özet yanıtta, sonra sayaçlar sıfırlanır.
+void PerfStats::rpcGetPerfStats(JsonVariantConst params, JsonWriter& response) {
+    const char* name = params["probe"] | "";
+    bool reset = params["reset"] | false;
+    
+    if (name[0] != '\0') {
+        int8_t probe = probeByName(name);
+        if (probe < 0) {
+            response.addf("error", "Unknown probe: %s", name);
+            return;
+        }
+        response.add("probe", name);
+        Perf.writeProbe(response, (PerfProbe)probe);
+    } else {
+        response.add("loop_n", (unsigned long)Perf._hist[(size_t)PerfProbe::LOOP_PERIOD].count);
+        response.add("loop_busy_p99", (unsigned long)Perf.percentile(PerfProbe::LOOP_BUSY, 99));
+        response.add("loop_late_max", (unsigned long)Perf._hist[(size_t)PerfProbe::LOOP_LATE].max);
+        response.add("rpc_p99", (unsigned long)Perf.percentile(PerfProbe::RPC_DISPATCH, 99));
+        response.add("rpc_max", (unsigned long)Perf._hist[(size_t)PerfProbe::RPC_DISPATCH].max);
+        if (!reset) {
+            Perf.requestReport();
+        }
+    }
+    
+    if (reset) {
+        Perf.reset();
+        response.add("reset", true);
+    }
+}
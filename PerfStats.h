@@ -0,0 +1,65 @@
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include "Config.h"
+#include "JsonWriter.h"
+
+// Ağ task'ı süre ölçümleri: her ölçüm noktası için log2 kovalı histogram (µs).
+// Sabit bellek, kilit yok - record() ve raporlar yalnızca ağ task'ından çağrılır.
+enum class PerfProbe : uint8_t {
+    LOOP_PERIOD,        // İki tur başlangıcı arası (uyku dahil)
+    LOOP_BUSY,          // Tur içi iş süresi (wait() hariç)
+    LOOP_LATE,          // Zaman aşımıyla uyanışta istenen zamandan gecikme (jitter)
+    STATE_BOOT,         // Durum handler'ları (DeviceState sırasıyla)
+    STATE_AP,
+    STATE_WIFI,
+    STATE_MQTT,
+    STATE_CONNECTED,
+    STATE_ERROR,
+    TB_LOOP,
+    OTA_LOOP,
+    LED_UPDATE,
+    RPC_DISPATCH,
+    COUNT
+};
+
+class PerfStats {
+public:
+    PerfStats();
+    
+    void begin();   // RPC kaydı
+    void loop();    // Ağ task'ı (bağlıyken): periyodik / istenen rapor
+    
+    // Kullanım: int64_t t0 = PerfStats::now(); ...; Perf.record(PerfProbe::TB_LOOP, t0);
+    static int64_t now() { return esp_timer_get_time(); }
+    void record(PerfProbe probe, int64_t startUs);
+    void add(PerfProbe probe, uint32_t us);
+    void reset();
+    
+    uint32_t percentile(PerfProbe probe, uint8_t pct);     // Kova üst sınırı, max ile kırpılır
+    void writeProbe(JsonWriter& json, PerfProbe probe);
+    void requestReport() { _reportPending = true; }
+
+private:
+    struct Histogram {
+        uint32_t buckets[PERF_BUCKETS];     // Kova i: [2^i, 2^(i+1)) µs, son kova üstünü de sayar
+        uint32_t count;
+        uint32_t max;
+        uint64_t total;
+    };
+    
+    Histogram _hist[(size_t)PerfProbe::COUNT];
+    unsigned long _lastReport;
+    bool _reportPending;
+    
+    static int8_t probeByName(const char* name);
+    static void writeReport(JsonWriter& json, void* ctx);
+    static void rpcGetPerfStats(JsonVariantConst params, JsonWriter& response);
+};
+
+extern PerfStats Perf;
+
+#endif // PERF_STATS_H
@@ -0,0 +1,122 @@
+#include "ProtoWriter.h"
+
+// Protobuf wire tipleri
+#define PROTO_WIRE_VARINT   0
+#define PROTO_WIRE_FIXED32  5
+#define PROTO_WIRE_LEN      2
+
+ProtoWriter::ProtoWriter(uint8_t* buf, size_t size) {
+    _buf = buf;
+    _size = size;
+    reset();
+}
+
+void ProtoWriter::reset() {
+    _len = 0;
+    _overflow = false;
+}
+
+void ProtoWriter::addBool(uint32_t field, bool value) {
+    tag(field, PROTO_WIRE_VARINT);
+    varint(value ? 1 : 0);
+}
+
+void ProtoWriter::addUInt(uint32_t field, uint32_t value) {
+    tag(field, PROTO_WIRE_VARINT);
+    varint(value);
+}
+
+void ProtoWriter::addSInt(uint32_t field, int32_t value) {
+    tag(field, PROTO_WIRE_VARINT);
+    varint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void ProtoWriter::addFloat(uint32_t field, float value) {
+    tag(field, PROTO_WIRE_FIXED32);
+    raw(&value, sizeof(value));     // ESP32 little-endian, protobuf da öyle
+}
+
+void ProtoWriter::addString(uint32_t field, const char* value) {
+    size_t len = strlen(value);
+    tag(field, PROTO_WIRE_LEN);
+    varint(len);
+    raw(value, len);
+}
+
+bool ProtoWriter::addJson(JsonObjectConst obj, const ProtoField* schema, size_t count) {
+    for (JsonPairConst kv : obj) {
+        const char* key = kv.key().c_str();
+        JsonVariantConst value = kv.value();
+        
+        const ProtoField* f = nullptr;
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(schema[i].key, key) == 0) {
+                f = &schema[i];
+                break;
+            }
+        }
+        if (f == nullptr) {
+            return false;
+        }
+        
+        switch (f->type) {
+            case ProtoType::BOOL:
+                if (!value.is<bool>()) return false;
+                addBool(f->number, value.as<bool>());
+                break;
+            case ProtoType::UINT32:
+                if (!value.is<unsigned long>()) return false;
+                addUInt(f->number, value.as<unsigned long>());
+                break;
+            case ProtoType::SINT32:
+                if (!value.is<long>()) return false;
+                addSInt(f->number, value.as<long>());
+                break;
+            case ProtoType::FLOAT:
+                if (!value.is<float>()) return false;
+                addFloat(f->number, value.as<float>());
+                break;
+            case ProtoType::STRING:
+                if (!value.is<const char*>()) return false;
+                addString(f->number, value.as<const char*>());
+                break;
+        }
+    }
+    return true;
+}
+
+const uint8_t* ProtoWriter::data() const {
+    return _buf;
+}
+
+size_t ProtoWriter::length() const {
+    return _len;
+}
+
+bool ProtoWriter::overflowed() const {
+    return _overflow;
+}
+
+void ProtoWriter::tag(uint32_t field, uint8_t wireType) {
+    varint((field << 3) | wireType);
+}
+
+void ProtoWriter::varint(uint32_t value) {
+    uint8_t bytes[5];
+    size_t n = 0;
+    do {
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        bytes[n++] = value ? (b | 0x80) : b;
+    } while (value);
+    raw(bytes, n);
+}
+
+void ProtoWriter::raw(const void* data, size_t len) {
+    if (_len + len > _size) {
+        _overflow = true;
+        return;
+    }
+    memcpy(_buf + _len, data, len);
+    _len += len;
+}
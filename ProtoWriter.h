@@ -0,0 +1,62 @@
+#ifndef PROTO_WRITER_H
+#define PROTO_WRITER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Sabit tampona yazan, heap kullanmayan protobuf kodlayıcı (yalnızca düz mesajlar).
+// ThingsBoard'un protobuf cihaz profili için: mesaj şeması cihaz profilinde
+// tanımlanır, burada anahtar -> alan numarası/tipi tablosu olarak tutulur.
+// Taşma olursa overflowed() true döner ve çıktı geçersiz sayılmalıdır.
+//
+//   uint8_t buf[JSON_BUFFER_SIZE];
+//   ProtoWriter proto(buf, sizeof(buf));
+//   proto.addBool(1, true);            // relay1
+//   publish(topic, proto.data(), proto.length());
+
+enum class ProtoType : uint8_t {
+    BOOL,
+    UINT32,     // varint
+    SINT32,     // zigzag varint (negatif değerler için kısa)
+    FLOAT,      // fixed32
+    STRING
+};
+
+struct ProtoField {
+    const char* key;
+    uint8_t number;
+    ProtoType type;
+};
+
+class ProtoWriter {
+public:
+    ProtoWriter(uint8_t* buf, size_t size);
+    
+    void reset();
+    
+    void addBool(uint32_t field, bool value);
+    void addUInt(uint32_t field, uint32_t value);
+    void addSInt(uint32_t field, int32_t value);
+    void addFloat(uint32_t field, float value);
+    void addString(uint32_t field, const char* value);
+    
+    // Düz JSON nesnesini şemaya göre kodlar. Şemada olmayan anahtar, iç içe
+    // değer veya tip uyuşmazlığında false (çağıran JSON'a geri dönmeli).
+    bool addJson(JsonObjectConst obj, const ProtoField* schema, size_t count);
+    
+    const uint8_t* data() const;
+    size_t length() const;
+    bool overflowed() const;
+
+private:
+    uint8_t* _buf;
+    size_t _size;
+    size_t _len;
+    bool _overflow;
+    
+    void tag(uint32_t field, uint8_t wireType);
+    void varint(uint32_t value);
+    void raw(const void* data, size_t len);
+};
+
+#endif // PROTO_WRITER_H
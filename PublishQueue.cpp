@@ -0,0 +1,103 @@
+#include "PublishQueue.h"
+
+PublishQueue::PublishQueue() {
+    clear();
+    _dropped = 0;
+    _merged = 0;
+}
+
+bool PublishQueue::push(PublishPriority priority, const char* topic, const uint8_t* payload, size_t length,
+                        uint8_t mergeKey, uint8_t replaces) {
+    size_t topicLen = strlen(topic);
+    if (topicLen >= PUBLISH_TOPIC_MAX || length > PUBLISH_PAYLOAD_MAX) {
+        DEBUG_PRINTF("[Outbox] Message for %s too large (%u bytes)\n", topic, (unsigned)length);
+        _dropped++;
+        return false;
+    }
+    
+    Lane& lane = _lanes[(size_t)priority];
+    
+    // Birleştirme: yeni mesajın kapsadığı bekleyenler silinir (ör. tam durum eski
+    // tam durumu ve delta'ları) - yerinde ezmek eski bir delta'yı sonraya bırakırdı
+    if (replaces != 0) {
+        removeKeys(lane, replaces);
+    }
+    
+    if (lane.count == PUBLISH_QUEUE_DEPTH) {
+        _dropped++;
+        if (priority == PublishPriority::RPC_RESPONSE) {
+            return false;
+        }
+        lane.head = (lane.head + 1) % PUBLISH_QUEUE_DEPTH;
+        lane.count--;
+    }
+    PublishMessage* msg = &lane.messages[(lane.head + lane.count) % PUBLISH_QUEUE_DEPTH];
+    lane.count++;
+    
+    memcpy(msg->topic, topic, topicLen + 1);
+    memcpy(msg->payload, payload, length);
+    msg->length = length;
+    msg->mergeKey = mergeKey;
+    return true;
+}
+
+bool PublishQueue::hasRoom(PublishPriority priority) {
+    return _lanes[(size_t)priority].count < PUBLISH_QUEUE_DEPTH;
+}
+
+const PublishMessage* PublishQueue::front() {
+    Lane* lane = frontLane();
+    return lane != nullptr ? &lane->messages[lane->head] : nullptr;
+}
+
+void PublishQueue::pop() {
+    Lane* lane = frontLane();
+    if (lane == nullptr) return;
+    lane->head = (lane->head + 1) % PUBLISH_QUEUE_DEPTH;
+    lane->count--;
+}
+
+bool PublishQueue::isEmpty() {
+    return frontLane() == nullptr;
+}
+
+void PublishQueue::clear() {
+    for (Lane& lane : _lanes) {
+        lane.head = 0;
+        lane.count = 0;
+    }
+}
+
+uint32_t PublishQueue::getDropped() {
+    return _dropped;
+}
+
+uint32_t PublishQueue::getMerged() {
+    return _merged;
+}
+
+// Sırayı koruyarak sıkıştırır
+void PublishQueue::removeKeys(Lane& lane, uint8_t replaces) {
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < lane.count; i++) {
+        PublishMessage& m = lane.messages[(lane.head + i) % PUBLISH_QUEUE_DEPTH];
+        if (m.mergeKey != 0 && (replaces & PUBLISH_MERGE_BIT(m.mergeKey))) {
+            _merged++;
+            continue;
+        }
+        if (kept != i) {
+            lane.messages[(lane.head + kept) % PUBLISH_QUEUE_DEPTH] = m;
+        }
+        kept++;
+    }
+    lane.count = kept;
+}
+
+PublishQueue::Lane* PublishQueue::frontLane() {
+    for (Lane& lane : _lanes) {
+        if (lane.count > 0) {
+            return &lane;
+        }
+    }
+    return nullptr;
+}
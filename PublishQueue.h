@@ -0,0 +1,60 @@
+#ifndef PUBLISH_QUEUE_H
+#define PUBLISH_QUEUE_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Giden MQTT mesajlarının önceliği (küçük değer önce gönderilir)
+enum class PublishPriority : uint8_t {
+    RPC_RESPONSE,   // Dolu: yeni yanıt reddedilir (ThingsBoard zaten zaman aşımına düşer)
+    STATE,          // Röle telemetry'si; dolu: en eski atılır
+    ATTRIBUTE,      // Dolu: en eski atılır (periyodik olarak yeniden gönderilir)
+    COUNT
+};
+
+struct PublishMessage {
+    char topic[PUBLISH_TOPIC_MAX];
+    uint8_t payload[PUBLISH_PAYLOAD_MAX];
+    uint16_t length;
+    uint8_t mergeKey;   // Mesaj türü (0: diğer) - push'taki replaces maskesiyle eşleşir
+};
+
+#define PUBLISH_MERGE_BIT(key)  (1u << (key))
+
+// Öncelik başına sabit boyutlu halka; heap kullanmaz.
+// Yalnızca ağ task'ından kullanılır.
+class PublishQueue {
+public:
+    PublishQueue();
+    
+    // replaces: bit k set ise bekleyen k türündeki mesajlar (k > 0) silinir.
+    // Yeni mesaj her zaman sona eklenir - eski bir değer yenisinin arkasında kalmaz.
+    bool push(PublishPriority priority, const char* topic, const uint8_t* payload, size_t length,
+              uint8_t mergeKey = 0, uint8_t replaces = 0);
+    bool hasRoom(PublishPriority priority);
+    
+    const PublishMessage* front();  // En yüksek öncelikli en eski mesaj, yoksa nullptr
+    void pop();
+    
+    bool isEmpty();
+    void clear();
+    
+    uint32_t getDropped();
+    uint32_t getMerged();
+
+private:
+    struct Lane {
+        PublishMessage messages[PUBLISH_QUEUE_DEPTH];
+        uint8_t head;
+        uint8_t count;
+    };
+    
+    Lane _lanes[(size_t)PublishPriority::COUNT];
+    uint32_t _dropped;
+    uint32_t _merged;
+    
+    Lane* frontLane();
+    void removeKeys(Lane& lane, uint8_t replaces);
+};
+
+#endif // PUBLISH_QUEUE_H
@@ -0,0 +1,260 @@
+#include "RelayActuator.h"
+#include "EventLoop.h"
+
+RelayActuator Actuator;
+
+RelayActuator::RelayActuator() : _lostChanges(0), _droppedCommands(0), _settledStates(0) {
+    _task = nullptr;
+    memset(_timers, 0, sizeof(_timers));
+    memset(_deadlines, 0, sizeof(_deadlines));
+    _revertStates = 0;
+}
+
+void RelayActuator::begin() {
+    _settledStates.store(Relays.getStatesBitmask());
+    
+    // Callback'ler esp_timer task'ında (öncelik 22) çalışır ve yalnızca komut kuyruklar
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        esp_timer_create_args_t args = {};
+        args.callback = timerCallback;
+        args.arg = (void*)(uintptr_t)(i + 1);
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "relay_timer";
+        if (esp_timer_create(&args, &_timers[i]) != ESP_OK) {
+            DEBUG_PRINTF("[Actuator] Failed to create timer for relay %d\n", i + 1);
+            _timers[i] = nullptr;
+        }
+    }
+    
+    BaseType_t res = xTaskCreatePinnedToCore(taskEntry, "relay", RELAY_TASK_STACK, this,
+                                             RELAY_TASK_PRIORITY, &_task, RELAY_TASK_CORE);
+    if (res != pdPASS) {
+        DEBUG_PRINTLN("[Actuator] Failed to create relay task");
+        _task = nullptr;
+        return;
+    }
+    
+    DEBUG_PRINTF("[Actuator] Relay task started on core %d\n", RELAY_TASK_CORE);
+}
+
+bool RelayActuator::submit(RelaySource source, const RelayCommand& cmd) {
+    if (_task == nullptr || source >= RelaySource::COUNT) {
+        return false;
+    }
+    
+    if (!_commands[(size_t)source].push(cmd)) {
+        _droppedCommands.fetch_add(1, std::memory_order_relaxed);
+        DEBUG_PRINTLN("[Actuator] Command queue full, command dropped");
+        return false;
+    }
+    
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+bool RelayActuator::setState(RelaySource source, uint8_t channel, bool state) {
+    return submit(source, RelayCommand{ RelayOp::SET, channel, state, 0, 0 });
+}
+
+bool RelayActuator::toggle(RelaySource source, uint8_t channel) {
+    return submit(source, RelayCommand{ RelayOp::TOGGLE, channel, false, 0, 0 });
+}
+
+bool RelayActuator::setAll(RelaySource source, bool state) {
+    return submit(source, RelayCommand{ RelayOp::SET_ALL, 0, state, 0, 0 });
+}
+
+bool RelayActuator::toggleAll(RelaySource source) {
+    return submit(source, RelayCommand{ RelayOp::TOGGLE_ALL, 0, false, 0, 0 });
+}
+
+bool RelayActuator::setMask(RelaySource source, uint8_t mask, uint8_t states) {
+    return submit(source, RelayCommand{ RelayOp::SET_MASK, 0, false, mask, states });
+}
+
+bool RelayActuator::setTimed(RelaySource source, uint8_t channel, bool state, uint32_t durationMs) {
+    return submit(source, RelayCommand{ RelayOp::TIMED, channel, state, 0, 0, durationMs });
+}
+
+bool RelayActuator::pulse(RelaySource source, uint8_t channel, uint32_t durationMs) {
+    return setTimed(source, channel, true, durationMs);
+}
+
+bool RelayActuator::pollChange(RelayChange& change) {
+    if (_changes.pop(change)) {
+        return true;
+    }
+    
+    // Kuyruk boşaldı - taşmada kaybolanlar güncel durumla tek olay olarak
+    uint8_t lost = _lostChanges.exchange(0, std::memory_order_acq_rel);
+    if (lost != 0) {
+        change.changed = lost;
+        change.states = Relays.getStatesBitmask();
+        return true;
+    }
+    return false;
+}
+
+bool RelayActuator::pollTimerEvent(RelayTimerEvent& event) {
+    return _timerEvents.pop(event);
+}
+
+uint8_t RelayActuator::getSettledStates() {
+    return _settledStates.load(std::memory_order_acquire);
+}
+
+uint32_t RelayActuator::getDroppedCommands() {
+    return _droppedCommands.load(std::memory_order_relaxed);
+}
+
+void RelayActuator::taskEntry(void* arg) {
+    static_cast<RelayActuator*>(arg)->run();
+}
+
+void RelayActuator::timerCallback(void* arg) {
+    uint8_t channel = (uint8_t)(uintptr_t)arg;
+    Actuator.submit(RelaySource::TIMER, RelayCommand{ RelayOp::EXPIRE, channel, false, 0, 0, 0 });
+}
+
+void RelayActuator::run() {
+    RelayCommand cmd;
+    
+    for (;;) {
+        // submit() bildirim verene kadar uyur
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        // Tüm kaynakları boşalt; bu sırada gelen komutlar yeni bildirim bırakır
+        for (size_t i = 0; i < (size_t)RelaySource::COUNT; i++) {
+            while (_commands[i].pop(cmd)) {
+                execute(cmd);
+            }
+        }
+    }
+}
+
+void RelayActuator::execute(const RelayCommand& cmd) {
+    uint8_t before = Relays.getStatesBitmask();
+    
+    // Elle / zamanlayıcıyla gelen komut, kanaldaki süreyi geçersiz kılar
+    switch (cmd.op) {
+        case RelayOp::SET:
+        case RelayOp::TOGGLE:
+        case RelayOp::TIMED:
+            if (cmd.channel >= 1 && cmd.channel <= RELAY_COUNT) {
+                cancelTimers(1 << (cmd.channel - 1));
+            }
+            break;
+        
+        case RelayOp::SET_ALL:
+        case RelayOp::TOGGLE_ALL:
+            cancelTimers(RELAY_ALL_MASK);
+            break;
+        
+        case RelayOp::SET_MASK:
+            cancelTimers(cmd.mask);
+            break;
+        
+        case RelayOp::EXPIRE:
+            break;
+    }
+    
+    switch (cmd.op) {
+        case RelayOp::SET:
+            Relays.setState(cmd.channel, cmd.state);
+            break;
+        
+        case RelayOp::TOGGLE:
+            Relays.toggle(cmd.channel);
+            break;
+        
+        case RelayOp::SET_ALL:
+            Relays.setAll(cmd.state);
+            break;
+        
+        case RelayOp::TOGGLE_ALL:
+            Relays.toggleAll();
+            break;
+        
+        case RelayOp::SET_MASK:
+            Relays.setMask(cmd.mask, cmd.states);
+            break;
+        
+        case RelayOp::TIMED:
+            if (Relays.setState(cmd.channel, cmd.state)) {
+                armTimer(cmd.channel, !cmd.state, cmd.durationMs);
+            }
+            break;
+        
+        case RelayOp::EXPIRE:
+            expireTimer(cmd.channel);
+            break;
+    }
+    
+    uint8_t after = Relays.getStatesBitmask();
+    updateSettled();
+    RelayChange change = { (uint8_t)(before ^ after), after };
+    if (change.changed == 0) return;
+    
+    if (!_changes.push(change)) {
+        _lostChanges.fetch_or(change.changed, std::memory_order_acq_rel);
+    }
+    
+    // GPIO zaten anahtarlandı - ağ task'ı telemetry / journal için uyanır
+    Events.wake();
+}
+
+void RelayActuator::armTimer(uint8_t channel, bool revertState, uint32_t durationMs) {
+    uint8_t idx = channel - 1;
+    if (_timers[idx] == nullptr || durationMs == 0) return;
+    
+    uint64_t us = (uint64_t)durationMs * 1000;
+    _deadlines[idx] = esp_timer_get_time() + us;
+    if (revertState) {
+        _revertStates |= (1 << idx);
+    } else {
+        _revertStates &= ~(1 << idx);
+    }
+    
+    if (esp_timer_start_once(_timers[idx], us) != ESP_OK) {
+        DEBUG_PRINTF("[Actuator] Failed to start timer for relay %d\n", channel);
+        _deadlines[idx] = 0;
+    }
+}
+
+void RelayActuator::cancelTimers(uint8_t mask) {
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        if ((mask & (1 << i)) && _deadlines[i] != 0) {
+            esp_timer_stop(_timers[i]);     // Zaten tetiklendiyse EXPIRE deadline ile elenir
+            _deadlines[i] = 0;
+        }
+    }
+}
+
+void RelayActuator::expireTimer(uint8_t channel) {
+    if (channel < 1 || channel > RELAY_COUNT) return;
+    uint8_t idx = channel - 1;
+    
+    // İptal edilmiş ya da yeniden kurulmuş timer'dan kalan komut
+    int64_t now = esp_timer_get_time();
+    if (_deadlines[idx] == 0 || now < _deadlines[idx]) return;
+    _deadlines[idx] = 0;
+    
+    bool state = _revertStates & (1 << idx);
+    Relays.setState(channel, state);
+    
+    RelayTimerEvent event = { channel, state, now };
+    if (!_timerEvents.push(event)) {
+        DEBUG_PRINTLN("[Actuator] Timer event queue full, event dropped");
+    }
+    Events.wake();
+}
+
+void RelayActuator::updateSettled() {
+    uint8_t timed = 0;
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        if (_deadlines[i] != 0) timed |= (1 << i);
+    }
+    
+    uint8_t states = Relays.getStatesBitmask();
+    _settledStates.store((states & ~timed) | (_revertStates & timed), std::memory_order_release);
+}
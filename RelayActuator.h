@@ -0,0 +1,118 @@
+#ifndef RELAY_ACTUATOR_H
+#define RELAY_ACTUATOR_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "Config.h"
+#include "RelayController.h"
+#include "SpscQueue.h"
+
+// Röle komutları RelayController'a yalnızca röle task'ı üzerinden ulaşır.
+// Ağ tarafı ne kadar yavaş olursa olsun komut -> GPIO gecikmesi sabit kalır.
+
+enum class RelayOp : uint8_t {
+    SET,
+    TOGGLE,
+    SET_ALL,
+    TOGGLE_ALL,
+    SET_MASK,
+    TIMED,      // Kanalı state yap, durationMs sonra tersine döndür
+    EXPIRE      // Süre doldu (yalnızca TIMER kaynağı)
+};
+
+struct RelayCommand {
+    RelayOp op;
+    uint8_t channel;    // SET / TOGGLE için 1..RELAY_COUNT
+    bool state;         // SET / SET_ALL için
+    uint8_t mask;       // SET_MASK: etkilenen kanallar
+    uint8_t states;     // SET_MASK: mask'taki kanalların hedef durumu
+    uint32_t durationMs;    // TIMED
+};
+
+// Komut üreticileri - her kaynak kendi SPSC kuyruğunu kullanır,
+// bu yüzden bir kaynak yalnızca tek bir task'tan komut göndermeli.
+// Yeni bir üretici task eklenirken buraya kaynak eklenir.
+enum class RelaySource : uint8_t {
+    NETWORK,    // MQTT RPC (ağ task'ı)
+    MODBUS,     // RS485 Modbus slave task'ı
+    SCHEDULER,  // Yerel zamanlayıcı task'ı
+    TIMER,      // esp_timer callback'leri (esp_timer task'ı)
+    COUNT
+};
+
+// Bir komutun sonucu: değişen kanallar ve sonraki tüm durumlar
+struct RelayChange {
+    uint8_t changed;
+    uint8_t states;
+};
+
+// Süreli moddaki kanalın süresi doldu ve kanal geri döndürüldü
+struct RelayTimerEvent {
+    uint8_t channel;
+    bool state;         // Geri dönülen durum (false: auto-off)
+    int64_t at;         // esp_timer_get_time() (us)
+};
+
+class RelayActuator {
+public:
+    RelayActuator();
+    
+    // Relays.begin()'den sonra çağrılmalı; röle task'ını başlatır
+    void begin();
+    
+    // false: kuyruk dolu, komut uygulanmayacak
+    bool submit(RelaySource source, const RelayCommand& cmd);
+    bool setState(RelaySource source, uint8_t channel, bool state);
+    bool toggle(RelaySource source, uint8_t channel);
+    bool setAll(RelaySource source, bool state);
+    bool toggleAll(RelaySource source);
+    bool setMask(RelaySource source, uint8_t mask, uint8_t states);
+    
+    // Kanalı state yapar, durationMs sonra esp_timer ile tersine döndürür (ana döngü
+    // yükünden bağımsız, ms hassasiyetinde). Aynı kanala gelen her komut süreyi iptal eder.
+    bool setTimed(RelaySource source, uint8_t channel, bool state, uint32_t durationMs);
+    bool pulse(RelaySource source, uint8_t channel, uint32_t durationMs);
+    
+    // Durum değişikliği olayları - tek tüketici (ağ task'ı)
+    bool pollChange(RelayChange& change);
+    bool pollTimerEvent(RelayTimerEvent& event);
+    
+    // Kalıcı durumlar: süreli kanallar süre sonunda dönecekleri durumla (journal için)
+    uint8_t getSettledStates();
+    
+    uint32_t getDroppedCommands();
+
+private:
+    TaskHandle_t _task;
+    SpscQueue<RelayCommand, RELAY_COMMAND_QUEUE_SIZE> _commands[(size_t)RelaySource::COUNT];
+    SpscQueue<RelayChange, RELAY_EVENT_QUEUE_SIZE> _changes;
+    
+    // Olay kuyruğu taşarsa değişen kanallar burada birikir, bir sonraki
+    // pollChange() ile birleştirilerek teslim edilir
+    std::atomic<uint8_t> _lostChanges;
+    std::atomic<uint32_t> _droppedCommands;
+    std::atomic<uint8_t> _settledStates;
+    
+    // Kanal başına tek atımlık timer. _deadlines ve _revertStates yalnızca röle task'ında;
+    // 0 = süre yok. Eski (iptal edilmiş / yeniden kurulmuş) EXPIRE komutları deadline ile elenir.
+    esp_timer_handle_t _timers[RELAY_COUNT];
+    int64_t _deadlines[RELAY_COUNT];
+    uint8_t _revertStates;
+    SpscQueue<RelayTimerEvent, RELAY_TIMER_EVENT_QUEUE_SIZE> _timerEvents;
+    
+    void run();
+    void execute(const RelayCommand& cmd);
+    void armTimer(uint8_t channel, bool revertState, uint32_t durationMs);
+    void cancelTimers(uint8_t mask);
+    void expireTimer(uint8_t channel);
+    void updateSettled();
+    static void taskEntry(void* arg);
+    static void timerCallback(void* arg);
+};
+
+extern RelayActuator Actuator;
+
+#endif // RELAY_ACTUATOR_H
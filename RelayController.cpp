@@ -1,24 +1,31 @@
 #include "RelayController.h"
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#include <driver/gpio.h>
 
 RelayController Relays;
 
-RelayController::RelayController() {
-    for (int i = 0; i < RELAY_COUNT; i++) {
-        _states[i] = false;
-    }
+RelayController::RelayController() : _states(0) {
 }
 
-void RelayController::begin() {
+void RelayController::begin(uint8_t states) {
     DEBUG_PRINTLN("[Relay] Initializing relays...");
     
     for (int i = 0; i < RELAY_COUNT; i++) {
         pinMode(_pins[i], OUTPUT);
-        digitalWrite(_pins[i], RELAY_OFF);
-        _states[i] = false;
+        digitalWrite(_pins[i], (states & (1 << i)) ? RELAY_ON : RELAY_OFF);
+        gpio_sleep_sel_dis((gpio_num_t)_pins[i]);     // Light sleep'te çıkış korunur
+        _bank0Bits[i] = _pins[i] < 32 ? (1UL << _pins[i]) : 0;
+        _bank1Bits[i] = _pins[i] < 32 ? 0 : (1UL << (_pins[i] - 32));
         DEBUG_PRINTF("[Relay] CH%d -> GPIO%d initialized\n", i + 1, _pins[i]);
     }
     
-    DEBUG_PRINTLN("[Relay] All relays initialized OFF");
+    _states.store(states & RELAY_ALL_MASK);
+    if (states == 0) {
+        DEBUG_PRINTLN("[Relay] All relays initialized OFF");
+    } else {
+        DEBUG_PRINTF("[Relay] Relays initialized with states 0x%02X\n", states);
+    }
 }
 
 bool RelayController::setState(uint8_t channel, bool state) {
@@ -28,11 +35,11 @@ bool RelayController::setState(uint8_t channel, bool state) {
     }
     
     uint8_t idx = channel - 1;
+    uint8_t states = _states.load();
     
-    if (_states[idx] != state) {
-        _states[idx] = state;
+    if (((states >> idx) & 1) != state) {
+        _states.store(states ^ (1 << idx));
         applyState(idx);
-        notifyChange(channel);
         DEBUG_PRINTF("[Relay] CH%d set to %s\n", channel, state ? "ON" : "OFF");
     }
     
@@ -46,11 +53,10 @@ bool RelayController::toggle(uint8_t channel) {
     }
     
     uint8_t idx = channel - 1;
-    _states[idx] = !_states[idx];
+    _states.store(_states.load() ^ (1 << idx));
     applyState(idx);
-    notifyChange(channel);
     
-    DEBUG_PRINTF("[Relay] CH%d toggled to %s\n", channel, _states[idx] ? "ON" : "OFF");
+    DEBUG_PRINTF("[Relay] CH%d toggled to %s\n", channel, getState(channel) ? "ON" : "OFF");
     return true;
 }
 
@@ -58,61 +64,85 @@ bool RelayController::getState(uint8_t channel) {
     if (channel < 1 || channel > RELAY_COUNT) {
         return false;
     }
-    return _states[channel - 1];
+    return (_states.load() >> (channel - 1)) & 1;
+}
+
+uint8_t RelayController::setMask(uint8_t mask, uint8_t states) {
+    uint8_t current = _states.load();
+    uint8_t changed = (current ^ states) & mask & RELAY_ALL_MASK;
+    if (changed == 0) {
+        return 0;
+    }
+    
+    uint8_t next = current ^ changed;
+    _states.store(next);
+    writeMask(changed, next);
+    
+    DEBUG_PRINTF("[Relay] Mask 0x%02X applied, states 0x%02X\n", changed, next);
+    return changed;
 }
 
 void RelayController::setAll(bool state) {
     DEBUG_PRINTF("[Relay] Setting ALL relays to %s\n", state ? "ON" : "OFF");
-    
-    for (int i = 0; i < RELAY_COUNT; i++) {
-        if (_states[i] != state) {
-            _states[i] = state;
-            applyState(i);
-            notifyChange(i + 1);
-        }
-    }
+    setMask(RELAY_ALL_MASK, state ? RELAY_ALL_MASK : 0);
 }
 
 void RelayController::toggleAll() {
     DEBUG_PRINTLN("[Relay] Toggling ALL relays");
-    
-    for (int i = 0; i < RELAY_COUNT; i++) {
-        _states[i] = !_states[i];
-        applyState(i);
-        notifyChange(i + 1);
-    }
+    setMask(RELAY_ALL_MASK, ~_states.load());
 }
 
-String RelayController::getStatesJson() {
-    String json = "{";
+void RelayController::writeStatesJson(JsonWriter& json, uint8_t mask) {
+    writeStatesJson(json, getStatesBitmask(), mask);
+}
+
+void RelayController::writeStatesJson(JsonWriter& json, uint8_t states, uint8_t mask) {
+    char key[8];
     for (int i = 0; i < RELAY_COUNT; i++) {
-        if (i > 0) json += ",";
-        json += "\"relay" + String(i + 1) + "\":" + (_states[i] ? "true" : "false");
+        if (!(mask & (1 << i))) continue;
+        snprintf(key, sizeof(key), "relay%d", i + 1);
+        json.add(key, (bool)((states >> i) & 1));
     }
-    json += "}";
-    return json;
 }
 
-uint8_t RelayController::getStatesBitmask() {
-    uint8_t mask = 0;
+void RelayController::writeStatesProto(ProtoWriter& proto, uint8_t mask) {
+    uint8_t states = getStatesBitmask();
     for (int i = 0; i < RELAY_COUNT; i++) {
-        if (_states[i]) {
-            mask |= (1 << i);
-        }
+        if (!(mask & (1 << i))) continue;
+        proto.addBool(i + 1, (states >> i) & 1);
     }
-    return mask;
 }
 
-void RelayController::setOnChangeCallback(void (*callback)(uint8_t channel, bool state)) {
-    _onChangeCallback = callback;
+uint8_t RelayController::getStatesBitmask() {
+    return _states.load();
 }
 
 void RelayController::applyState(uint8_t idx) {
-    digitalWrite(_pins[idx], _states[idx] ? RELAY_ON : RELAY_OFF);
+    digitalWrite(_pins[idx], getState(idx + 1) ? RELAY_ON : RELAY_OFF);
 }
 
-void RelayController::notifyChange(uint8_t channel) {
-    if (_onChangeCallback != nullptr) {
-        _onChangeCallback(channel, _states[channel - 1]);
+// mask'taki kanalları set/clear register'larıyla tek seferde yazar.
+// Röleler iki GPIO bank'ına dağılmış durumda; kritik bölge iki bank arasında
+// kesme/task geçişini engeller, böylece tüm kanallar aynı anda anahtarlanır.
+void RelayController::writeMask(uint8_t mask, uint8_t states) {
+    uint32_t high0 = 0, low0 = 0, high1 = 0, low1 = 0;
+    
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (!(mask & (1 << i))) continue;
+        bool level = ((states >> i) & 1) ? RELAY_ON : RELAY_OFF;
+        if (level) {
+            high0 |= _bank0Bits[i];
+            high1 |= _bank1Bits[i];
+        } else {
+            low0 |= _bank0Bits[i];
+            low1 |= _bank1Bits[i];
+        }
     }
+    
+    portENTER_CRITICAL(&_gpioMux);
+    REG_WRITE(GPIO_OUT_W1TS_REG, high0);
+    REG_WRITE(GPIO_OUT1_W1TS_REG, high1);
+    REG_WRITE(GPIO_OUT_W1TC_REG, low0);
+    REG_WRITE(GPIO_OUT1_W1TC_REG, low1);
+    portEXIT_CRITICAL(&_gpioMux);
 }
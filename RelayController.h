@@ -2,40 +2,50 @@
 #define RELAY_CONTROLLER_H
 
 #include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
 #include "Config.h"
+#include "JsonWriter.h"
+#include "ProtoWriter.h"
 
+// Durum değiştiren çağrılar yalnızca röle task'ından (RelayActuator) yapılır;
+// okuma (getState, getStatesBitmask, writeStatesJson) her task'tan güvenlidir.
 class RelayController {
 public:
     RelayController();
     
-    void begin();
+    void begin(uint8_t states = 0);    // Başlangıç durumları (geri yükleme), varsayılan tümü kapalı
     
     // Röle kontrol
     bool setState(uint8_t channel, bool state);
     bool toggle(uint8_t channel);
     bool getState(uint8_t channel);
     
-    // Toplu işlemler
+    // Toplu işlemler - mask'taki kanallar aynı anda anahtarlanır
+    uint8_t setMask(uint8_t mask, uint8_t states);  // Değişen kanalları döner
     void setAll(bool state);
     void toggleAll();
     
     // Durum sorgulama
-    String getStatesJson();
+    void writeStatesJson(JsonWriter& json, uint8_t mask = 0xFF);   // Açık nesneye "relayN" alanlarını ekler
+    static void writeStatesJson(JsonWriter& json, uint8_t states, uint8_t mask);
+    void writeStatesProto(ProtoWriter& proto, uint8_t mask = 0xFF);    // relayN -> alan N
     uint8_t getStatesBitmask();
-    
-    // Callback (durum değiştiğinde çağrılır)
-    void setOnChangeCallback(void (*callback)(uint8_t channel, bool state));
 
 private:
-    bool _states[RELAY_COUNT];
+    std::atomic<uint8_t> _states;   // Bit i = kanal i+1
     uint8_t _pins[RELAY_COUNT] = {
         GPIO_RELAY_1, GPIO_RELAY_2, GPIO_RELAY_3,
         GPIO_RELAY_4, GPIO_RELAY_5, GPIO_RELAY_6
     };
-    void (*_onChangeCallback)(uint8_t channel, bool state) = nullptr;
+    
+    // Kanal başına GPIO bank (0: GPIO0-31, 1: GPIO32-53) bitleri
+    uint32_t _bank0Bits[RELAY_COUNT];
+    uint32_t _bank1Bits[RELAY_COUNT];
+    portMUX_TYPE _gpioMux = portMUX_INITIALIZER_UNLOCKED;
     
     void applyState(uint8_t channel);
-    void notifyChange(uint8_t channel);
+    void writeMask(uint8_t mask, uint8_t states);
 };
 
 extern RelayController Relays;
@@ -0,0 +1,104 @@
+#include "RelayJournal.h"
+#include "EventLoop.h"
+
+RelayJournal Journal;
+
+// [63..16] sıra numarası, [15..8] ~states, [7..0] states
+static uint64_t packEntry(uint32_t seq, uint8_t states) {
+    return ((uint64_t)seq << 16) | ((uint16_t)(uint8_t)~states << 8) | states;
+}
+
+RelayJournal::RelayJournal() {
+    _seq = 0;
+    _written = 0;
+    _pending = 0;
+    _dirty = false;
+    _dirtySince = 0;
+    _changedAt = 0;
+}
+
+uint8_t RelayJournal::begin() {
+#if RELAY_RESTORE_ON_BOOT
+    _prefs.begin(NVS_NAMESPACE, true);
+    uint64_t entry = _prefs.getULong64(NVS_KEY_RELAYS, 0);
+    _prefs.end();
+    
+    uint8_t states = entry & 0xFF;
+    uint8_t check = (entry >> 8) & 0xFF;
+    if (entry == 0 || check != (uint8_t)~states || (states & ~RELAY_ALL_MASK)) {
+        DEBUG_PRINTLN("[Journal] No saved relay states");
+        return 0;
+    }
+    
+    _seq = entry >> 16;
+    _written = states;
+    _pending = states;
+    DEBUG_PRINTF("[Journal] Restoring states 0x%02X (seq %u)\n", states, _seq);
+    return states;
+#else
+    return 0;
+#endif
+}
+
+void RelayJournal::record(uint8_t states) {
+#if RELAY_RESTORE_ON_BOOT
+    if (states == _pending && (_dirty || states == _written)) return;
+    
+    unsigned long now = millis();
+    _pending = states;
+    _changedAt = now;
+    
+    // Yazılmış duruma geri dönüldüyse yazmaya gerek yok
+    if (states == _written) {
+        _dirty = false;
+        return;
+    }
+    if (!_dirty) {
+        _dirty = true;
+        _dirtySince = now;
+    }
+#endif
+}
+
+void RelayJournal::loop() {
+    if (!_dirty) return;
+    
+    // Durum oturunca yaz; sürekli değişiyorsa da en geç MAX_DELAY'de
+    unsigned long now = millis();
+    if (now - _changedAt >= RELAY_JOURNAL_SETTLE_MS || now - _dirtySince >= RELAY_JOURNAL_MAX_DELAY_MS) {
+        write();
+    }
+    
+    if (_dirty) {
+        Events.dueAt(_changedAt + RELAY_JOURNAL_SETTLE_MS);
+        Events.dueAt(_dirtySince + RELAY_JOURNAL_MAX_DELAY_MS);
+    }
+}
+
+void RelayJournal::flush() {
+    if (_dirty) {
+        write();
+    }
+}
+
+uint32_t RelayJournal::getSequence() {
+    return _seq;
+}
+
+void RelayJournal::write() {
+    _prefs.begin(NVS_NAMESPACE, false);
+    bool ok = _prefs.putULong64(NVS_KEY_RELAYS, packEntry(_seq + 1, _pending)) == sizeof(uint64_t);
+    _prefs.end();
+    
+    if (!ok) {
+        // Bir sonraki denemeye kadar yeniden MAX_DELAY beklenir
+        DEBUG_PRINTLN("[Journal] NVS write failed");
+        _dirtySince = millis();
+        return;
+    }
+    
+    _dirty = false;
+    _seq++;
+    _written = _pending;
+    DEBUG_PRINTF("[Journal] Saved states 0x%02X (seq %u)\n", _written, _seq);
+}
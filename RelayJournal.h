@@ -0,0 +1,40 @@
+#ifndef RELAY_JOURNAL_H
+#define RELAY_JOURNAL_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Config.h"
+
+// Röle durumlarının NVS'te saklanması ve açılışta geri yüklenmesi.
+// Kayıt: sıra numarası + bitmask + ters bitmask (tek 8 baytlık NVS girdisi).
+// NVS kendisi log yapılıdır - her yazma yeni girdi olarak eklenir ve sayfalara
+// yayılır; hızlı anahtarlama ise burada tek yazmada birleştirilir.
+class RelayJournal {
+public:
+    RelayJournal();
+    
+    // Relays.begin()'den önce: son kaydı okur. Geri yüklenecek durumlar (kapalıysa 0)
+    uint8_t begin();
+    
+    // Ağ task'ı: kalıcı durum değişti (süreli kanallar dönüş durumuyla)
+    void record(uint8_t states);
+    void loop();        // Ağ task'ı: süresi dolan değişikliği yazar
+    void flush();       // Yeniden başlatma / OTA öncesi bekleyeni hemen yaz
+    
+    uint32_t getSequence();
+
+private:
+    Preferences _prefs;
+    uint32_t _seq;
+    uint8_t _written;       // NVS'teki son durum
+    uint8_t _pending;
+    bool _dirty;
+    unsigned long _dirtySince;
+    unsigned long _changedAt;
+    
+    void write();
+};
+
+extern RelayJournal Journal;
+
+#endif // RELAY_JOURNAL_H
@@ -0,0 +1,530 @@
+#include "RelayScheduler.h"
+#include <time.h>
+#include "RelayActuator.h"
+#include "ThingsBoardMQTT.h"
+#include "TelemetryQueue.h"
+#include "EventLoop.h"
+
+// 29 Şubat gibi kurallar için dört yıl ileriye bakılır
+#define SCHEDULE_SEARCH_DAYS    1462
+#define SCHEDULE_TIME_POLL_MS   1000    // Saat henüz senkron değilken kontrol aralığı
+
+RelayScheduler Schedule;
+
+RelayScheduler::RelayScheduler() {
+    memset(_rules, 0, sizeof(_rules));
+    _heapSize = 0;
+    _heapDirty = true;
+    _lock = nullptr;
+    _task = nullptr;
+    _listDirty = false;
+}
+
+void RelayScheduler::begin() {
+    // Cron alanları yerel saatle değerlendirilir
+    setenv("TZ", LOCAL_TIMEZONE, 1);
+    tzset();
+    
+    _lock = xSemaphoreCreateMutex();
+    load();
+    
+    TB.registerRpc(RPC_METHOD("addSchedule"), rpcAddSchedule);
+    TB.registerRpc(RPC_METHOD("removeSchedule"), rpcRemoveSchedule);
+    TB.registerRpc(RPC_METHOD("getSchedules"), rpcGetSchedules);
+    
+    xTaskCreatePinnedToCore(taskEntry, "scheduler", SCHEDULE_TASK_STACK, this,
+                            SCHEDULE_TASK_PRIORITY, &_task, SCHEDULE_TASK_CORE);
+    
+    DEBUG_PRINTF("[Schedule] %u rules loaded\n", (unsigned)count());
+}
+
+void RelayScheduler::loop() {
+    // RPC yanıtları ve röle telemetry'si önce
+    if (!TB.outboxIdle()) {
+        return;
+    }
+    
+    // Her çalışma, zaman damgasıyla ayrı bir telemetry kaydı
+    Run run;
+    if (_runs.pop(run)) {
+        char buf[JSON_BUFFER_SIZE];
+        JsonWriter json(buf, sizeof(buf));
+        json.beginObject();
+        json.add("ts", (unsigned long long)run.at * 1000);
+        json.beginObject("values");
+        json.add("schedule_run", (unsigned)run.id);
+        json.endObject();
+        json.endObject();
+        
+        if (!TB.publish(TB_TELEMETRY_TOPIC, json)) {
+            DEBUG_PRINTLN("[Schedule] Run report send failed");
+        }
+        return;
+    }
+    
+    if (_listDirty) {
+        publishList();
+    }
+}
+
+uint8_t RelayScheduler::addCron(const char* expr, uint8_t mask, uint8_t states, const char*& error) {
+    ScheduleRule rule;
+    memset(&rule, 0, sizeof(rule));
+    
+    if (strlen(expr) >= sizeof(rule.cron) || !parseCron(expr, rule)) {
+        error = "Invalid cron expression";
+        return 0;
+    }
+    strcpy(rule.cron, expr);
+    rule.mask = mask;
+    rule.states = states;
+    
+    uint8_t id = store(rule);
+    if (id == 0) {
+        error = "Schedule table full";
+    }
+    return id;
+}
+
+uint8_t RelayScheduler::addOnce(uint32_t at, uint8_t mask, uint8_t states, const char*& error) {
+    if (TelemetryQueue::timeValid() && at <= (uint32_t)time(nullptr)) {
+        error = "Time is in the past";
+        return 0;
+    }
+    
+    ScheduleRule rule;
+    memset(&rule, 0, sizeof(rule));
+    rule.flags = SCHEDULE_FLAG_ONCE;
+    rule.at = at;
+    rule.mask = mask;
+    rule.states = states;
+    
+    uint8_t id = store(rule);
+    if (id == 0) {
+        error = "Schedule table full";
+    }
+    return id;
+}
+
+bool RelayScheduler::remove(uint8_t id) {
+    if (id == 0 || id > SCHEDULE_MAX_RULES) return false;
+    
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    bool found = _rules[id - 1].id != 0;
+    if (found) {
+        memset(&_rules[id - 1], 0, sizeof(ScheduleRule));
+        save();
+        changed();
+    }
+    xSemaphoreGive(_lock);
+    
+    return found;
+}
+
+size_t RelayScheduler::count() {
+    size_t n = 0;
+    for (const ScheduleRule& r : _rules) {
+        if (r.id != 0) n++;
+    }
+    return n;
+}
+
+uint32_t RelayScheduler::nextRun(uint8_t id) {
+    if (id == 0 || id > SCHEDULE_MAX_RULES || !TelemetryQueue::timeValid()) return 0;
+    
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    ScheduleRule rule = _rules[id - 1];
+    xSemaphoreGive(_lock);
+    
+    return rule.id != 0 ? computeNext(rule, time(nullptr) - 1) : 0;
+}
+
+void RelayScheduler::publishList() {
+    // Akış iki geçişte yazılır - anlık görüntü üzerinden
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    memcpy(_listRules, _rules, sizeof(_rules));
+    xSemaphoreGive(_lock);
+    
+    uint32_t now = TelemetryQueue::timeValid() ? time(nullptr) : 0;
+    for (size_t i = 0; i < SCHEDULE_MAX_RULES; i++) {
+        _listNext[i] = (_listRules[i].id != 0 && now != 0) ? computeNext(_listRules[i], now - 1) : 0;
+    }
+    
+    _listDirty = false;
+    if (!TB.publishStream(TB_ATTRIBUTES_TOPIC, writeList, this)) {
+        _listDirty = true;
+    }
+}
+
+// {"schedules":[{"id":1,"cron":"0 18 * * 1-5","mask":1,"states":1,"next":1718000000},
+//               {"id":2,"at":1718003600,"mask":1,"states":0,"next":1718003600}]}
+void RelayScheduler::writeList(JsonWriter& json, void* ctx) {
+    const RelayScheduler* self = static_cast<const RelayScheduler*>(ctx);
+    
+    json.beginObject();
+    json.beginArray("schedules");
+    for (size_t i = 0; i < SCHEDULE_MAX_RULES; i++) {
+        const ScheduleRule& r = self->_listRules[i];
+        if (r.id == 0) continue;
+        
+        json.beginObject();
+        json.add("id", (unsigned)r.id);
+        if (r.flags & SCHEDULE_FLAG_ONCE) {
+            json.add("at", (unsigned long)r.at);
+        } else {
+            json.add("cron", r.cron);
+        }
+        json.add("mask", (unsigned)r.mask);
+        json.add("states", (unsigned)r.states);
+        json.add("next", (unsigned long)self->_listNext[i]);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+}
+
+// ============================================
+// Zamanlayıcı task'ı
+// ============================================
+
+void RelayScheduler::taskEntry(void* arg) {
+    static_cast<RelayScheduler*>(arg)->run();
+}
+
+void RelayScheduler::run() {
+    for (;;) {
+        uint32_t waitMs = SCHEDULE_TIME_POLL_MS;
+        
+        if (TelemetryQueue::timeValid()) {
+            uint64_t nowMs = TelemetryQueue::epochMs();
+            uint32_t now = nowMs / 1000;
+            waitMs = SCHEDULE_MAX_SLEEP_MS;
+            
+            xSemaphoreTake(_lock, portMAX_DELAY);
+            if (_heapDirty) {
+                rebuildHeap(now);
+            }
+            fireDue(now);
+            
+            // En yakın çalışmaya kadar (ms hassasiyetle) uyu
+            if (_heapSize > 0) {
+                uint64_t dueMs = (uint64_t)_heap[0].at * 1000;
+                if (dueMs - nowMs < waitMs) {
+                    waitMs = dueMs - nowMs;
+                }
+            }
+            xSemaphoreGive(_lock);
+        }
+        
+        // Kural değişince changed() erken uyandırır
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    }
+}
+
+// Süresi gelen tüm kurallar; kaçırılan birden fazla cron çalışması tek çalışmaya iner
+void RelayScheduler::fireDue(uint32_t now) {
+    while (_heapSize > 0 && _heap[0].at <= now) {
+        HeapEntry e = heapPop();
+        ScheduleRule& r = _rules[e.slot];
+        if (r.id == 0) continue;
+        
+        DEBUG_PRINTF("[Schedule] Rule %u fired: mask=0x%02X states=0x%02X\n", r.id, r.mask, r.states);
+        if (!Actuator.setMask(RelaySource::SCHEDULER, r.mask, r.states)) {
+            DEBUG_PRINTLN("[Schedule] Relay queue full, run skipped");
+        }
+        
+        Run run = { r.id, now };
+        _runs.push(run);    // Dolu ise (uzun süre çevrimdışı) rapor atlanır, röle olayları yine Backlog'da
+        Events.wake();
+        
+        if (r.flags & SCHEDULE_FLAG_ONCE) {
+            memset(&r, 0, sizeof(r));
+            save();
+            _listDirty = true;
+        } else {
+            uint32_t next = computeNext(r, max(now, e.at));
+            if (next != 0) {
+                heapPush(next, e.slot);
+            }
+        }
+    }
+}
+
+void RelayScheduler::rebuildHeap(uint32_t now) {
+    _heapSize = 0;
+    for (uint8_t i = 0; i < SCHEDULE_MAX_RULES; i++) {
+        if (_rules[i].id == 0) continue;
+        
+        // now - 1: tam bu saniyedeki çalışma kaçırılmasın
+        uint32_t next = computeNext(_rules[i], now - 1);
+        if (next != 0) {
+            heapPush(next, i);
+        }
+    }
+    _heapDirty = false;
+}
+
+void RelayScheduler::heapPush(uint32_t at, uint8_t slot) {
+    size_t i = _heapSize++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (_heap[parent].at <= at) break;
+        _heap[i] = _heap[parent];
+        i = parent;
+    }
+    _heap[i] = HeapEntry{ at, slot };
+}
+
+RelayScheduler::HeapEntry RelayScheduler::heapPop() {
+    HeapEntry top = _heap[0];
+    HeapEntry last = _heap[--_heapSize];
+    
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= _heapSize) break;
+        if (child + 1 < _heapSize && _heap[child + 1].at < _heap[child].at) child++;
+        if (last.at <= _heap[child].at) break;
+        _heap[i] = _heap[child];
+        i = child;
+    }
+    if (_heapSize > 0) {
+        _heap[i] = last;
+    }
+    return top;
+}
+
+// after'dan kesin olarak sonraki ilk çalışma (epoch saniye), yoksa 0
+uint32_t RelayScheduler::computeNext(const ScheduleRule& rule, uint32_t after) {
+    if (rule.flags & SCHEDULE_FLAG_ONCE) {
+        return rule.at;
+    }
+    
+    // Cron dakika çözünürlüğünde: sonraki dakika başından aranır
+    time_t t = (time_t)after - (after % 60) + 60;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    
+    for (int day = 0; day < SCHEDULE_SEARCH_DAYS; day++) {
+        int startHour = tm.tm_hour;
+        int startMin = tm.tm_min;
+        
+        if ((rule.months & (1 << (tm.tm_mon + 1))) && dayMatches(rule, tm)) {
+            for (int h = startHour; h < 24; h++) {
+                if (!(rule.hours & (1UL << h))) continue;
+                
+                for (int m = (h == startHour) ? startMin : 0; m < 60; m++) {
+                    if (!(rule.minutes & (1ULL << m))) continue;
+                    
+                    tm.tm_hour = h;
+                    tm.tm_min = m;
+                    tm.tm_sec = 0;
+                    tm.tm_isdst = -1;
+                    time_t result = mktime(&tm);
+                    if (result > (time_t)after) {
+                        return result;
+                    }
+                }
+            }
+        }
+        
+        // Ertesi gün 00:00 (mktime ay/yıl taşmasını ve tm_wday'i düzeltir)
+        tm.tm_mday++;
+        tm.tm_hour = 0;
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        mktime(&tm);
+    }
+    return 0;
+}
+
+// Cron kuralı: gün ve haftanın günü ikisi de kısıtlıysa biri yeterli
+bool RelayScheduler::dayMatches(const ScheduleRule& rule, const struct tm& tm) {
+    bool dom = rule.days & (1UL << tm.tm_mday);
+    bool dow = rule.weekdays & (1 << tm.tm_wday);
+    
+    if (!(rule.flags & SCHEDULE_FLAG_DOM_ANY) && !(rule.flags & SCHEDULE_FLAG_DOW_ANY)) {
+        return dom || dow;
+    }
+    return dom && dow;
+}
+
+// ============================================
+// Kural tablosu ve NVS
+// ============================================
+
+uint8_t RelayScheduler::store(const ScheduleRule& rule) {
+    uint8_t id = 0;
+    
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    for (uint8_t i = 0; i < SCHEDULE_MAX_RULES; i++) {
+        if (_rules[i].id == 0) {
+            _rules[i] = rule;
+            _rules[i].id = i + 1;
+            id = i + 1;
+            save();
+            changed();
+            break;
+        }
+    }
+    xSemaphoreGive(_lock);
+    
+    return id;
+}
+
+void RelayScheduler::load() {
+    _prefs.begin(NVS_NAMESPACE, true);
+    if (_prefs.getBytesLength(NVS_KEY_SCHEDULE) == sizeof(_rules)) {
+        _prefs.getBytes(NVS_KEY_SCHEDULE, _rules, sizeof(_rules));
+    }
+    _prefs.end();
+    
+    // Bozuk kayıtlara karşı: id slotla uyuşmalı
+    for (uint8_t i = 0; i < SCHEDULE_MAX_RULES; i++) {
+        if (_rules[i].id != 0 && _rules[i].id != i + 1) {
+            memset(&_rules[i], 0, sizeof(ScheduleRule));
+        }
+    }
+    _listDirty = true;
+}
+
+// Kilit tutulurken çağrılır
+void RelayScheduler::save() {
+    _prefs.begin(NVS_NAMESPACE, false);
+    _prefs.putBytes(NVS_KEY_SCHEDULE, _rules, sizeof(_rules));
+    _prefs.end();
+}
+
+// Kilit tutulurken çağrılır
+void RelayScheduler::changed() {
+    _heapDirty = true;
+    _listDirty = true;
+    if (_task != nullptr) {
+        xTaskNotifyGive(_task);
+    }
+}
+
+// ============================================
+// Cron ayrıştırma: "dakika saat gün ay haftanın_günü"
+// Alan: *, n, a-b, */s, a-b/s, n/s ve virgülle listeler
+// ============================================
+
+bool RelayScheduler::parseCron(const char* expr, ScheduleRule& rule) {
+    const char* p = expr;
+    uint64_t bits;
+    bool any;
+    
+    if (!parseField(p, 0, 59, bits, any)) return false;
+    rule.minutes = bits;
+    if (!parseField(p, 0, 23, bits, any)) return false;
+    rule.hours = bits;
+    if (!parseField(p, 1, 31, bits, any)) return false;
+    rule.days = bits;
+    if (any) rule.flags |= SCHEDULE_FLAG_DOM_ANY;
+    if (!parseField(p, 1, 12, bits, any)) return false;
+    rule.months = bits;
+    if (!parseField(p, 0, 7, bits, any)) return false;
+    rule.weekdays = (bits | (bits >> 7)) & 0x7F;   // 7 = Pazar
+    if (any) rule.flags |= SCHEDULE_FLAG_DOW_ANY;
+    
+    while (*p == ' ') p++;
+    return *p == '\0';
+}
+
+bool RelayScheduler::parseField(const char*& p, int lo, int hi, uint64_t& bits, bool& any) {
+    while (*p == ' ') p++;
+    bits = 0;
+    any = (p[0] == '*' && (p[1] == ' ' || p[1] == '\0'));
+    
+    for (;;) {
+        int from;
+        int to;
+        int step = 1;
+        
+        if (*p == '*') {
+            from = lo;
+            to = hi;
+            p++;
+        } else {
+            if (!isdigit((unsigned char)*p)) return false;
+            from = strtol(p, (char**)&p, 10);
+            to = from;
+            if (*p == '-') {
+                p++;
+                if (!isdigit((unsigned char)*p)) return false;
+                to = strtol(p, (char**)&p, 10);
+            }
+        }
+        
+        if (*p == '/') {
+            p++;
+            if (!isdigit((unsigned char)*p)) return false;
+            step = strtol(p, (char**)&p, 10);
+            if (step <= 0) return false;
+            if (from == to) to = hi;    // "5/15" = 5'ten itibaren her 15
+        }
+        
+        if (from < lo || to > hi || from > to) return false;
+        for (int v = from; v <= to; v += step) {
+            bits |= 1ULL << v;
+        }
+        
+        if (*p != ',') break;
+        p++;
+    }
+    
+    return (*p == ' ' || *p == '\0') && bits != 0;
+}
+
+// ============================================
+// RPC metotları
+// ============================================
+
+// {"method":"addSchedule","params":{"cron":"0 18 * * 1-5","mask":1,"states":1}}
+// {"method":"addSchedule","params":{"at":1718003600,"mask":1,"states":0}}
+void RelayScheduler::rpcAddSchedule(JsonVariantConst params, JsonWriter& response) {
+    long mask = params["mask"] | -1L;
+    long states = params["states"] | -1L;
+    
+    if (mask <= 0 || mask > RELAY_ALL_MASK || states < 0 || states > RELAY_ALL_MASK) {
+        response.add("error", "Invalid mask or states");
+        return;
+    }
+    
+    const char* cron = params["cron"].as<const char*>();
+    unsigned long at = params["at"] | 0UL;
+    const char* error = "cron or at required";
+    uint8_t id = 0;
+    
+    if (cron != nullptr) {
+        id = Schedule.addCron(cron, (uint8_t)mask, (uint8_t)states, error);
+    } else if (at != 0) {
+        id = Schedule.addOnce(at, (uint8_t)mask, (uint8_t)states, error);
+    }
+    
+    if (id == 0) {
+        response.add("error", error);
+        return;
+    }
+    response.add("id", (unsigned)id);
+    response.add("next", (unsigned long)Schedule.nextRun(id));
+}
+
+// {"method":"removeSchedule","params":{"id":1}}
+void RelayScheduler::rpcRemoveSchedule(JsonVariantConst params, JsonWriter& response) {
+    int id = params["id"] | 0;
+    
+    if (id < 1 || id > SCHEDULE_MAX_RULES || !Schedule.remove(id)) {
+        response.add("error", "Unknown schedule id");
+        return;
+    }
+    response.add("removed", id);
+}
+
+// {"method":"getSchedules","params":{}}
+// Liste RPC yanıtına sığmayabilir: "schedules" attribute'u olarak yeniden gönderilir
+void RelayScheduler::rpcGetSchedules(JsonVariantConst params, JsonWriter& response) {
+    response.add("count", (unsigned)Schedule.count());
+    Schedule._listDirty = true;
+}
@@ -0,0 +1,102 @@
+#ifndef RELAY_SCHEDULER_H
+#define RELAY_SCHEDULER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "Config.h"
+#include "JsonWriter.h"
+#include "SpscQueue.h"
+
+// Cihaz üzerinde röle zamanlayıcı: cron kuralları ve tek seferlik zamanlar.
+// Kurallar NVS'te saklanır, RPC ile yönetilir; SNTP saatiyle (yerel saat dilimi)
+// kendi task'ında çalışır, bu yüzden bulut veya WiFi kesintisinden etkilenmez.
+// Bir sonraki çalışma zamanına göre min-heap tutulur; task en yakın zamana kadar uyur.
+
+#define SCHEDULE_FLAG_ONCE      0x01    // Tek seferlik (at), çalışınca silinir
+#define SCHEDULE_FLAG_DOM_ANY   0x02    // Cron gün alanı '*'
+#define SCHEDULE_FLAG_DOW_ANY   0x04    // Cron haftanın günü alanı '*'
+
+struct ScheduleRule {
+    uint8_t id;             // 1..SCHEDULE_MAX_RULES, 0: boş slot
+    uint8_t mask;           // Etkilenen kanallar (bit 0 = relay1)
+    uint8_t states;         // Bu kanalların hedef durumu
+    uint8_t flags;
+    uint32_t at;            // Tek seferlik: epoch saniye
+    uint64_t minutes;       // Cron: bit n = dakika n
+    uint32_t hours;
+    uint32_t days;          // bit 1..31
+    uint16_t months;        // bit 1..12
+    uint8_t weekdays;       // bit 0 = Pazar
+    char cron[SCHEDULE_CRON_MAX_LEN];   // Listeleme için orijinal ifade
+};
+
+class RelayScheduler {
+public:
+    RelayScheduler();
+    
+    // Actuator.begin()'den sonra; kuralları NVS'ten yükler, RPC'leri kaydeder, task'ı başlatır
+    void begin();
+    void loop();    // Ağ task'ı (bağlıyken): çalışma kayıtları ve kural listesi
+    
+    // Ağ task'ından çağrılır. id döner, hata durumunda 0 (error doldurulur)
+    uint8_t addCron(const char* expr, uint8_t mask, uint8_t states, const char*& error);
+    uint8_t addOnce(uint32_t at, uint8_t mask, uint8_t states, const char*& error);
+    bool remove(uint8_t id);
+    size_t count();
+    uint32_t nextRun(uint8_t id);   // Epoch saniye, bilinmiyorsa 0
+    void publishList();             // Kural listesini "schedules" attribute'u olarak gönder
+
+private:
+    struct HeapEntry {
+        uint32_t at;
+        uint8_t slot;
+    };
+    
+    struct Run {
+        uint8_t id;
+        uint32_t at;
+    };
+    
+    ScheduleRule _rules[SCHEDULE_MAX_RULES];
+    HeapEntry _heap[SCHEDULE_MAX_RULES];
+    size_t _heapSize;
+    bool _heapDirty;                        // Kurallar değişti / saat yeni geçerli oldu
+    
+    SemaphoreHandle_t _lock;                // _rules, _heap: ağ task'ı <-> zamanlayıcı task'ı
+    TaskHandle_t _task;
+    Preferences _prefs;
+    
+    SpscQueue<Run, SCHEDULE_RUN_QUEUE_SIZE> _runs;  // Zamanlayıcı task'ı -> ağ task'ı
+    volatile bool _listDirty;
+    ScheduleRule _listRules[SCHEDULE_MAX_RULES];    // Akışla gönderilen liste anlık görüntüsü
+    uint32_t _listNext[SCHEDULE_MAX_RULES];
+    
+    void run();
+    void fireDue(uint32_t now);
+    void rebuildHeap(uint32_t now);
+    void heapPush(uint32_t at, uint8_t slot);
+    HeapEntry heapPop();
+    uint32_t computeNext(const ScheduleRule& rule, uint32_t after);
+    bool dayMatches(const ScheduleRule& rule, const struct tm& tm);
+    uint8_t store(const ScheduleRule& rule);
+    void load();
+    void save();
+    void changed();
+    
+    static bool parseCron(const char* expr, ScheduleRule& rule);
+    static bool parseField(const char*& p, int lo, int hi, uint64_t& bits, bool& any);
+    static void writeList(JsonWriter& json, void* ctx);
+    static void taskEntry(void* arg);
+    
+    static void rpcAddSchedule(JsonVariantConst params, JsonWriter& response);
+    static void rpcRemoveSchedule(JsonVariantConst params, JsonWriter& response);
+    static void rpcGetSchedules(JsonVariantConst params, JsonWriter& response);
+};
+
+extern RelayScheduler Schedule;
+
+#endif // RELAY_SCHEDULER_H
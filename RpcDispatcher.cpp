@@ -0,0 +1,63 @@
+#include "RpcDispatcher.h"
+
+static_assert((RPC_MAX_METHODS & (RPC_MAX_METHODS - 1)) == 0, "RPC_MAX_METHODS must be a power of two");
+
+RpcDispatcher::RpcDispatcher() {
+    memset(_table, 0, sizeof(_table));
+    _count = 0;
+}
+
+bool RpcDispatcher::registerRpc(const RpcMethod& method, RpcHandler handler) {
+    if (find(method.name, method.hash) != nullptr) {
+        DEBUG_PRINTF("[RPC] Method already registered: %s\n", method.name);
+        return false;
+    }
+    
+    if (_count >= RPC_MAX_METHODS) {
+        DEBUG_PRINTF("[RPC] Table full, cannot register %s\n", method.name);
+        return false;
+    }
+    
+    size_t idx = method.hash & (TABLE_SIZE - 1);
+    while (_table[idx].name != nullptr) {
+        idx = (idx + 1) & (TABLE_SIZE - 1);
+    }
+    
+    _table[idx].hash = method.hash;
+    _table[idx].name = method.name;
+    _table[idx].handler = handler;
+    _count++;
+    
+    return true;
+}
+
+bool RpcDispatcher::dispatch(const char* method, JsonVariantConst params, JsonWriter& response) {
+    const Entry* entry = find(method, rpcHash(method));
+    
+    response.beginObject();
+    if (entry != nullptr) {
+        entry->handler(params, response);
+    } else {
+        response.addf("error", "Unknown method: %s", method);
+    }
+    response.endObject();
+    
+    return entry != nullptr;
+}
+
+size_t RpcDispatcher::count() {
+    return _count;
+}
+
+const RpcDispatcher::Entry* RpcDispatcher::find(const char* method, uint32_t hash) {
+    size_t idx = hash & (TABLE_SIZE - 1);
+    
+    // Boş slota kadar lineer arama (silme yok, bu yeterli)
+    while (_table[idx].name != nullptr) {
+        if (_table[idx].hash == hash && strcmp(_table[idx].name, method) == 0) {
+            return &_table[idx];
+        }
+        idx = (idx + 1) & (TABLE_SIZE - 1);
+    }
+    return nullptr;
+}
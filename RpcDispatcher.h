@@ -0,0 +1,56 @@
+#ifndef RPC_DISPATCHER_H
+#define RPC_DISPATCHER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <type_traits>
+#include "Config.h"
+#include "JsonWriter.h"
+
+// RPC handler: params okunur, yanıt alanları açık nesneye yazılır.
+// Hata durumunda "error" alanı eklenir. Handler MQTT publish yapmamalı -
+// yanıt, handler döndükten sonra gönderilir.
+typedef void (*RpcHandler)(JsonVariantConst params, JsonWriter& response);
+
+// FNV-1a (32 bit) - derleme zamanında da hesaplanabilir
+constexpr uint32_t rpcHash(const char* str, uint32_t hash = 2166136261u) {
+    return *str ? rpcHash(str + 1, (hash ^ (uint8_t)*str) * 16777619u) : hash;
+}
+
+struct RpcMethod {
+    const char* name;
+    uint32_t hash;
+};
+
+// Metot adı ve derleme zamanında hesaplanmış hash'i
+#define RPC_METHOD(name) RpcMethod{ name, std::integral_constant<uint32_t, rpcHash(name)>::value }
+
+class RpcDispatcher {
+public:
+    RpcDispatcher();
+    
+    // name kalıcı olmalı (string literal)
+    bool registerRpc(const RpcMethod& method, RpcHandler handler);
+    
+    // false: metot bulunamadı (yanıtta "error" yazılır)
+    bool dispatch(const char* method, JsonVariantConst params, JsonWriter& response);
+    
+    size_t count();
+
+private:
+    // Açık adresleme, 2'nin kuvveti boyut - yük oranı <= %50
+    static const size_t TABLE_SIZE = RPC_MAX_METHODS * 2;
+    
+    struct Entry {
+        uint32_t hash;
+        const char* name;
+        RpcHandler handler;
+    };
+    
+    Entry _table[TABLE_SIZE];
+    size_t _count;
+    
+    const Entry* find(const char* method, uint32_t hash);
+};
+
+#endif // RPC_DISPATCHER_H
@@ -0,0 +1,62 @@
+#include "SensorDrivers.h"
+
+// ============================================
+// SHT3x
+// ============================================
+
+#define SHT3X_CMD_SOFT_RESET    0x30A2
+#define SHT3X_CMD_MEASURE_HIGH  0x2400  // Tek ölçüm, yüksek tekrarlanabilirlik, clock stretching yok
+#define SHT3X_MEASURE_MS        16
+#define SHT3X_RESET_MS          2
+
+static bool sht3xCommand(TwoWire& wire, uint8_t address, uint16_t cmd) {
+    wire.beginTransmission(address);
+    wire.write(cmd >> 8);
+    wire.write(cmd & 0xFF);
+    return wire.endTransmission() == 0;
+}
+
+// CRC-8, polinom 0x31, başlangıç 0xFF
+static uint8_t sht3xCrc(const uint8_t* data) {
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+bool sht3xBegin(TwoWire& wire, uint8_t address) {
+    if (!sht3xCommand(wire, address, SHT3X_CMD_SOFT_RESET)) {
+        return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(SHT3X_RESET_MS));
+    return true;
+}
+
+bool sht3xRead(TwoWire& wire, uint8_t address, float* values) {
+    if (!sht3xCommand(wire, address, SHT3X_CMD_MEASURE_HIGH)) {
+        return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(SHT3X_MEASURE_MS));
+    
+    uint8_t buf[6];
+    if (wire.requestFrom(address, (size_t)sizeof(buf)) != sizeof(buf)) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = wire.read();
+    }
+    
+    if (sht3xCrc(buf) != buf[2] || sht3xCrc(buf + 3) != buf[5]) {
+        return false;
+    }
+    
+    uint16_t rawT = (buf[0] << 8) | buf[1];
+    uint16_t rawH = (buf[3] << 8) | buf[4];
+    values[0] = -45.0f + 175.0f * rawT / 65535.0f;
+    values[1] = 100.0f * rawH / 65535.0f;
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef SENSOR_DRIVERS_H
+#define SENSOR_DRIVERS_H
+
+#include "SensorHub.h"
+
+// Hazır I2C sensör sürücüleri (SensorDef.begin / SensorDef.read).
+// Sensör task'ında çalışırlar; bekleme vTaskDelay ile yapılır.
+
+// Sensirion SHT3x (SHT30/31/35): sıcaklık (°C), bağıl nem (%)
+// Adres 0x44 (ADDR low) veya 0x45
+#define SHT3X_ADDRESS       0x44
+bool sht3xBegin(TwoWire& wire, uint8_t address);
+bool sht3xRead(TwoWire& wire, uint8_t address, float* values);
+
+#endif // SENSOR_DRIVERS_H
@@ -0,0 +1,191 @@
+#include "SensorHub.h"
+#include <float.h>
+#include "ThingsBoardMQTT.h"
+#include "TelemetryQueue.h"
+#include "EventLoop.h"
+
+SensorHub Sensors;
+
+SensorHub::SensorHub() {
+    _sensorCount = 0;
+    _channelCount = 0;
+    _task = nullptr;
+    _errors = 0;
+    _droppedWindows = 0;
+    resetWindow();
+}
+
+bool SensorHub::addSensor(const SensorDef& sensor) {
+    if (_task != nullptr || _sensorCount >= SENSOR_MAX_SENSORS ||
+        _channelCount + sensor.valueCount > SENSOR_MAX_CHANNELS) {
+        DEBUG_PRINTF("[Sensor] Cannot add sensor %s\n", sensor.name);
+        return false;
+    }
+    _sensors[_sensorCount] = sensor;
+    _online[_sensorCount] = false;
+    _sensorCount++;
+    _channelCount += sensor.valueCount;
+    return true;
+}
+
+void SensorHub::begin() {
+    if (_sensorCount == 0) {
+        DEBUG_PRINTLN("[Sensor] No sensors registered, sampling disabled");
+        return;
+    }
+    
+    Wire.begin(GPIO_I2C_SDA, GPIO_I2C_SCL, SENSOR_I2C_FREQ);
+    
+    xTaskCreatePinnedToCore(taskEntry, "sensors", SENSOR_TASK_STACK, this,
+                            SENSOR_TASK_PRIORITY, &_task, SENSOR_TASK_CORE);
+    
+    DEBUG_PRINTF("[Sensor] Sampling %u sensors (%u values) every %d ms\n",
+                 _sensorCount, _channelCount, SENSOR_SAMPLE_INTERVAL_MS);
+}
+
+void SensorHub::loop() {
+    // RPC yanıtları ve röle telemetry'si önce
+    if (!TB.outboxIdle()) {
+        return;
+    }
+    
+    if (!_windows.pop(_sending)) {
+        return;
+    }
+    
+    if (TB.publishStream(TB_TELEMETRY_TOPIC, writeJson, this)) {
+        DEBUG_PRINTLN("[Sensor] Aggregated telemetry sent");
+    } else {
+        DEBUG_PRINTLN("[Sensor] Aggregated telemetry send failed");
+    }
+}
+
+uint32_t SensorHub::getErrorCount() {
+    return _errors;
+}
+
+void SensorHub::taskEntry(void* arg) {
+    static_cast<SensorHub*>(arg)->run();
+}
+
+void SensorHub::run() {
+    for (size_t i = 0; i < _sensorCount; i++) {
+        probe(i);
+    }
+    
+    TickType_t lastWake = xTaskGetTickCount();
+    TickType_t windowStart = lastWake;
+    
+    for (;;) {
+        sample();
+        
+        if (xTaskGetTickCount() - windowStart >= pdMS_TO_TICKS(SENSOR_WINDOW_MS)) {
+            windowStart += pdMS_TO_TICKS(SENSOR_WINDOW_MS);
+            closeWindow();
+        }
+        
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SENSOR_SAMPLE_INTERVAL_MS));
+    }
+}
+
+void SensorHub::probe(size_t index) {
+    const SensorDef& s = _sensors[index];
+    _online[index] = s.begin == nullptr || s.begin(Wire, s.address);
+    if (!_online[index]) {
+        DEBUG_PRINTF("[Sensor] %s not responding at 0x%02X\n", s.name, s.address);
+    }
+}
+
+void SensorHub::sample() {
+    float values[SENSOR_MAX_CHANNELS];
+    size_t channel = 0;
+    
+    for (size_t i = 0; i < _sensorCount; i++) {
+        const SensorDef& s = _sensors[i];
+        
+        if (_online[i] && !s.read(Wire, s.address, values)) {
+            _errors++;
+            _online[i] = false;     // Pencere sonunda yeniden denenir
+        }
+        
+        if (_online[i]) {
+            for (uint8_t v = 0; v < s.valueCount; v++) {
+                Aggregate& a = _current.values[channel + v];
+                float x = values[v];
+                if (isnan(x)) continue;
+                
+                if (x < a.min) a.min = x;
+                if (x > a.max) a.max = x;
+                a.sum += x;
+                a.last = x;
+                a.count++;
+            }
+        }
+        channel += s.valueCount;
+    }
+}
+
+void SensorHub::closeWindow() {
+    _current.ts = TelemetryQueue::timeValid() ? TelemetryQueue::epochMs() : 0;
+    if (!_windows.push(_current)) {
+        _droppedWindows++;  // Ağ task'ı yetişemedi (bağlantı yok)
+    }
+    Events.wake();
+    resetWindow();
+    
+    for (size_t i = 0; i < _sensorCount; i++) {
+        if (!_online[i]) {
+            probe(i);
+        }
+    }
+}
+
+void SensorHub::resetWindow() {
+    for (size_t i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+        Aggregate& a = _current.values[i];
+        a.min = FLT_MAX;
+        a.max = -FLT_MAX;
+        a.sum = 0;
+        a.last = 0;
+        a.count = 0;
+    }
+}
+
+// {"ts":1718000000000,"values":{"temperature":23.4,"temperature_min":23.1,
+//  "temperature_max":23.9,"temperature_mean":23.45, ...}}
+// Pencerede hiç örneği olmayan kanal yazılmaz.
+void SensorHub::writeJson(JsonWriter& json, void* ctx) {
+    const SensorHub* self = static_cast<const SensorHub*>(ctx);
+    const Window& window = self->_sending;
+    char key[48];
+    size_t channel = 0;
+    
+    json.beginObject();
+    if (window.ts != 0) {
+        json.add("ts", (unsigned long long)window.ts);
+        json.beginObject("values");
+    }
+    
+    for (size_t i = 0; i < self->_sensorCount; i++) {
+        const SensorDef& s = self->_sensors[i];
+        for (uint8_t v = 0; v < s.valueCount; v++) {
+            const Aggregate& a = window.values[channel + v];
+            if (a.count == 0) continue;
+            
+            const char* name = s.keys[v];
+            json.add(name, a.last);
+            snprintf(key, sizeof(key), "%s_min", name);
+            json.add(key, a.min);
+            snprintf(key, sizeof(key), "%s_max", name);
+            json.add(key, a.max);
+            snprintf(key, sizeof(key), "%s_mean", name);
+            json.add(key, a.sum / a.count);
+        }
+        channel += s.valueCount;
+    }
+    
+    if (window.ts != 0) {
+        json.endObject();
+    }
+    json.endObject();
+}
@@ -0,0 +1,82 @@
+#ifndef SENSOR_HUB_H
+#define SENSOR_HUB_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "Config.h"
+#include "JsonWriter.h"
+#include "SpscQueue.h"
+
+// I2C sensör sürücüsü. begin bir kez (ve hata sonrası her pencerede),
+// read her örneklemede sensör task'ından çağrılır.
+// read, values[0..valueCount) doldurur; false: örnek atlanır.
+typedef bool (*SensorBeginFn)(TwoWire& wire, uint8_t address);
+typedef bool (*SensorReadFn)(TwoWire& wire, uint8_t address, float* values);
+
+struct SensorDef {
+    const char* name;           // Log için
+    uint8_t address;            // 7 bit I2C adresi
+    uint8_t valueCount;
+    const char* const* keys;    // valueCount adet telemetry anahtarı (kalıcı)
+    SensorBeginFn begin;
+    SensorReadFn read;
+};
+
+// Kayıtlı sensörleri sabit aralıkla örnekler, her pencere için kanal başına
+// min/max/ortalama/son değeri tutar ve pencere sonunda tek kayıt olarak
+// ağ task'ına verir. Sunucuya ham örnek gitmez.
+class SensorHub {
+public:
+    SensorHub();
+    
+    // begin()'den önce çağrılmalı
+    bool addSensor(const SensorDef& sensor);
+    
+    void begin();   // I2C + örnekleme task'ı
+    void loop();    // Ağ task'ı: tamamlanan pencereyi telemetry olarak gönderir
+    
+    uint32_t getErrorCount();
+
+private:
+    struct Aggregate {
+        float min;
+        float max;
+        float sum;
+        float last;
+        uint16_t count;
+    };
+    
+    // Bir pencerenin sonucu
+    struct Window {
+        uint64_t ts;            // Epoch ms, saat senkron değilse 0
+        Aggregate values[SENSOR_MAX_CHANNELS];
+    };
+    
+    SensorDef _sensors[SENSOR_MAX_SENSORS];
+    bool _online[SENSOR_MAX_SENSORS];
+    size_t _sensorCount;
+    size_t _channelCount;
+    
+    TaskHandle_t _task;
+    
+    Window _current;                        // Örnekleme task'ı doldurur
+    SpscQueue<Window, 2> _windows;          // Örnekleme task'ı -> ağ task'ı
+    Window _sending;                        // Ağ task'ında akışla gönderilen pencere
+    
+    volatile uint32_t _errors;
+    volatile uint32_t _droppedWindows;
+    
+    void run();
+    void sample();
+    void closeWindow();
+    void resetWindow();
+    void probe(size_t index);
+    static void writeJson(JsonWriter& json, void* ctx);
+    static void taskEntry(void* arg);
+};
+
+extern SensorHub Sensors;
+
+#endif // SENSOR_HUB_H
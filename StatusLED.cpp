@@ -1,4 +1,5 @@
 #include "StatusLED.h"
+#include "EventLoop.h"
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
@@ -27,8 +28,10 @@ void StatusLED::update() {
         if (now >= _flashEndTime) {
             _flashActive = false;
             writeColor(_preFlashColor);
+        } else {
+            Events.dueAt(_flashEndTime);
+            return;
         }
-        return;
     }
     
     // Blink kontrolü
@@ -38,6 +41,7 @@ void StatusLED::update() {
             _blinkState = !_blinkState;
             writeColor(_blinkState ? _currentColor : LED_COLOR_OFF);
         }
+        Events.dueAt(_lastBlinkTime + _blinkInterval);
     }
 }
 
@@ -106,6 +110,7 @@ void StatusLED::flash(uint32_t color, uint16_t durationMs) {
     _flashActive = true;
     _flashEndTime = millis() + durationMs;
     writeColor(color);
+    Events.dueAt(_flashEndTime);
 }
 
 void StatusLED::writeColor(uint32_t color) {
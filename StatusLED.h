@@ -21,7 +21,7 @@ public:
     StatusLED();
     
     void begin();
-    void update();  // loop() içinde çağrılmalı
+    void update();  // Ağ task'ının her turunda; sonraki değişim zamanını Events'e bildirir
     
     void setStatus(LedStatus status);
     void setColor(uint32_t color);
@@ -0,0 +1,388 @@
+#include "TelemetryQueue.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include <stddef.h>
+
+TelemetryQueue Backlog;
+
+// Flash düzeni: her 4 KB sektörün ilk slotu başlık, kalan 255 slot kayıt
+static const uint32_t SECTOR_SIZE = 4096;
+static const uint32_t SLOTS_PER_SECTOR = SECTOR_SIZE / sizeof(RelayEvent);
+static const uint32_t SECTOR_MAGIC = 0x31514254;   // "TBQ1"
+
+static const uint8_t MARKER_EMPTY = 0xFF;
+static const uint8_t MARKER_VALID = 0xA5;
+static const uint8_t MARKER_CONSUMED = 0x00;
+
+// 2024-01-01 öncesi = SNTP henüz senkronize değil
+static const time_t TIME_VALID_AFTER = 1704067200;
+
+struct SectorHeader {
+    uint32_t magic;
+    uint32_t seq;
+    uint8_t reserved[8];
+};
+
+TelemetryQueue::TelemetryQueue() {
+    _ring = nullptr;
+    _capacity = 0;
+    _head = 0;
+    _count = 0;
+    _bootId = 0;
+    _dropped = 0;
+    _part = nullptr;
+    _sectorCount = 0;
+    _seq = 0;
+    _writeSector = 0;
+    _writeSlot = 0;
+    _readSector = 0;
+    _readSlot = 0;
+    _flashCount = 0;
+}
+
+void TelemetryQueue::begin() {
+    DEBUG_PRINTLN("[Queue] Initializing offline telemetry queue...");
+    
+    _bootId = (uint16_t)esp_random();
+    
+    // Önce PSRAM, yoksa dahili RAM'de küçük bir halka
+    _capacity = TELEMETRY_QUEUE_CAPACITY;
+    _ring = (RelayEvent*)heap_caps_malloc(_capacity * sizeof(RelayEvent), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (_ring == nullptr) {
+        _capacity = TELEMETRY_QUEUE_CAPACITY_NOPSRAM;
+        _ring = (RelayEvent*)heap_caps_malloc(_capacity * sizeof(RelayEvent), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        DEBUG_PRINTLN("[Queue] No PSRAM, using internal RAM");
+    }
+    if (_ring == nullptr) {
+        _capacity = 0;
+        DEBUG_PRINTLN("[Queue] Allocation failed, queue disabled");
+    }
+    
+    // Opsiyonel flash taşma alanı (partitions.csv içinde tanımlıysa)
+    _part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, TELEMETRY_SPILL_PARTITION);
+    if (_part != nullptr && _part->size / SECTOR_SIZE >= 2) {
+        _sectorCount = _part->size / SECTOR_SIZE;
+        flashScan();
+        DEBUG_PRINTF("[Queue] Spill partition '%s': %u sectors, %u pending events\n",
+                     TELEMETRY_SPILL_PARTITION, _sectorCount, (unsigned)_flashCount);
+    } else {
+        _part = nullptr;
+        DEBUG_PRINTLN("[Queue] No spill partition, flash spill disabled");
+    }
+    
+    DEBUG_PRINTF("[Queue] Ready - capacity: %u events\n", (unsigned)_capacity);
+}
+
+void TelemetryQueue::push(uint8_t changed, uint8_t states) {
+    if (_capacity == 0) {
+        _dropped++;
+        return;
+    }
+    
+    RelayEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    if (timeValid()) {
+        ev.ts = epochMs();
+        ev.flags = EVENT_TS_EPOCH;
+    } else {
+        ev.ts = esp_timer_get_time() / 1000;
+    }
+    ev.bootId = _bootId;
+    ev.changed = changed;
+    ev.states = states;
+    
+    if (_count == _capacity) {
+        spill();
+    }
+    
+    // Flash yoksa (veya yazılamadıysa) en eski olay düşer
+    if (_count == _capacity) {
+        _head = (_head + 1) % _capacity;
+        _count--;
+        _dropped++;
+    }
+    
+    _ring[(_head + _count) % _capacity] = ev;
+    _count++;
+}
+
+size_t TelemetryQueue::peek(RelayEvent* out, size_t max) {
+    size_t n = 0;
+    
+    // Önce flash (daha eski)
+    if (_part != nullptr && _flashCount > 0) {
+        uint32_t sector = _readSector;
+        uint32_t slot = _readSlot;
+        while (n < max && n < _flashCount) {
+            if (!flashNext(sector, slot, out[n])) break;
+            slot++;
+            n++;
+        }
+    }
+    
+    // Sonra RAM
+    for (size_t i = 0; n < max && i < _count; i++) {
+        out[n++] = _ring[(_head + i) % _capacity];
+    }
+    
+    return n;
+}
+
+void TelemetryQueue::pop(size_t count) {
+    while (count > 0 && _part != nullptr && _flashCount > 0) {
+        RelayEvent ev;
+        if (!flashNext(_readSector, _readSlot, ev)) {
+            _flashCount = 0;
+            break;
+        }
+        flashConsume(_readSector, _readSlot);
+        _readSlot++;
+        _flashCount--;
+        count--;
+    }
+    
+    size_t n = min(count, _count);
+    if (n > 0) {
+        _head = (_head + n) % _capacity;
+        _count -= n;
+    }
+}
+
+size_t TelemetryQueue::size() {
+    return _flashCount + _count;
+}
+
+bool TelemetryQueue::isEmpty() {
+    return size() == 0;
+}
+
+uint32_t TelemetryQueue::getDropped() {
+    return _dropped;
+}
+
+bool TelemetryQueue::resolveTimestamp(const RelayEvent& ev, uint64_t& out) {
+    if (ev.flags & EVENT_TS_EPOCH) {
+        out = ev.ts;
+        return true;
+    }
+    
+    // Uptime damgası yalnızca aynı açılışta ve saat senkronken çevrilebilir
+    if (ev.bootId != _bootId || !timeValid()) {
+        return false;
+    }
+    
+    uint64_t uptimeMs = esp_timer_get_time() / 1000;
+    out = epochMs() - (uptimeMs - ev.ts);
+    return true;
+}
+
+bool TelemetryQueue::timeValid() {
+    return time(nullptr) > TIME_VALID_AFTER;
+}
+
+uint64_t TelemetryQueue::epochMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+}
+
+// ============================================
+// Flash taşma alanı
+// ============================================
+
+void TelemetryQueue::spill() {
+    size_t n = min((size_t)TELEMETRY_SPILL_BATCH, _count);
+    if (_part == nullptr || n == 0) return;
+    
+    DEBUG_PRINTF("[Queue] RAM full, spilling %u events to flash\n", (unsigned)n);
+    
+    for (size_t i = 0; i < n; i++) {
+        RelayEvent ev = _ring[_head];
+        
+        // Mümkünse epoch'a çevir - uptime damgası yeniden başlatmadan sonra anlamsız
+        uint64_t ts;
+        if (!(ev.flags & EVENT_TS_EPOCH) && resolveTimestamp(ev, ts)) {
+            ev.ts = ts;
+            ev.flags |= EVENT_TS_EPOCH;
+        }
+        
+        if (!flashAppend(ev)) return;
+        
+        _head = (_head + 1) % _capacity;
+        _count--;
+    }
+}
+
+bool TelemetryQueue::flashAppend(const RelayEvent& src) {
+    if (_flashCount == 0) {
+        _readSector = _writeSector;
+        _readSlot = _writeSlot;
+    }
+    
+    if (_writeSlot >= SLOTS_PER_SECTOR) {
+        uint32_t next = (_writeSector + 1) % _sectorCount;
+        
+        // Halka doldu: en eski sektörün okunmamış kayıtları kaybolur
+        if (_flashCount > 0 && next == _readSector) {
+            size_t lost = 0;
+            RelayEvent ev;
+            for (uint32_t slot = 1; slot < SLOTS_PER_SECTOR; slot++) {
+                if (flashRead(next, slot, ev) && ev.marker == MARKER_VALID) lost++;
+            }
+            _dropped += lost;
+            _flashCount -= min(lost, _flashCount);
+            _readSector = (next + 1) % _sectorCount;
+            _readSlot = 1;
+        }
+        
+        if (!openSector(next)) return false;
+        _writeSector = next;
+        _writeSlot = 1;
+        
+        if (_flashCount == 0) {
+            _readSector = _writeSector;
+            _readSlot = _writeSlot;
+        }
+    }
+    
+    RelayEvent ev = src;
+    ev.marker = MARKER_VALID;
+    ev.crc = crc16(ev);
+    
+    if (esp_partition_write(_part, slotOffset(_writeSector, _writeSlot), &ev, sizeof(ev)) != ESP_OK) {
+        DEBUG_PRINTLN("[Queue] Flash write failed");
+        return false;
+    }
+    
+    _writeSlot++;
+    _flashCount++;
+    return true;
+}
+
+bool TelemetryQueue::flashRead(uint32_t sector, uint32_t slot, RelayEvent& ev) {
+    if (esp_partition_read(_part, slotOffset(sector, slot), &ev, sizeof(ev)) != ESP_OK) {
+        return false;
+    }
+    return ev.marker != MARKER_VALID || ev.crc == crc16(ev);
+}
+
+bool TelemetryQueue::flashNext(uint32_t& sector, uint32_t& slot, RelayEvent& ev) {
+    // (sector, slot) konumundan itibaren yazma konumuna kadar ilk geçerli kaydı bul
+    for (uint32_t guard = 0; guard < _sectorCount * SLOTS_PER_SECTOR; guard++) {
+        if (sector == _writeSector && slot >= _writeSlot) return false;
+        
+        if (slot >= SLOTS_PER_SECTOR) {
+            sector = (sector + 1) % _sectorCount;
+            slot = 1;
+            continue;
+        }
+        
+        if (flashRead(sector, slot, ev) && ev.marker == MARKER_VALID) return true;
+        slot++;
+    }
+    return false;
+}
+
+void TelemetryQueue::flashConsume(uint32_t sector, uint32_t slot) {
+    // Silme yok - yalnızca işaret baytı 0xA5 -> 0x00 (bitler 1'den 0'a yazılabilir)
+    uint8_t marker = MARKER_CONSUMED;
+    esp_partition_write(_part, slotOffset(sector, slot) + offsetof(RelayEvent, marker), &marker, 1);
+}
+
+void TelemetryQueue::flashScan() {
+    bool found = false;
+    uint32_t oldest = 0, newest = 0;
+    uint32_t oldestSeq = 0, newestSeq = 0;
+    
+    for (uint32_t s = 0; s < _sectorCount; s++) {
+        SectorHeader hdr;
+        if (esp_partition_read(_part, s * SECTOR_SIZE, &hdr, sizeof(hdr)) != ESP_OK) continue;
+        if (hdr.magic != SECTOR_MAGIC) continue;
+        
+        if (!found || (int32_t)(hdr.seq - oldestSeq) < 0) {
+            oldest = s;
+            oldestSeq = hdr.seq;
+        }
+        if (!found || (int32_t)(hdr.seq - newestSeq) > 0) {
+            newest = s;
+            newestSeq = hdr.seq;
+        }
+        found = true;
+    }
+    
+    _flashCount = 0;
+    
+    if (!found) {
+        // Boş alan - ilk yazma 0. sektörü açar
+        _seq = 0;
+        _writeSector = _sectorCount - 1;
+        _writeSlot = SLOTS_PER_SECTOR;
+        _readSector = _writeSector;
+        _readSlot = _writeSlot;
+        return;
+    }
+    
+    _seq = newestSeq;
+    _writeSector = newest;
+    _writeSlot = 1;
+    
+    RelayEvent ev;
+    while (_writeSlot < SLOTS_PER_SECTOR && flashRead(newest, _writeSlot, ev) && ev.marker != MARKER_EMPTY) {
+        _writeSlot++;
+    }
+    
+    // En eskiden en yeniye okunmamış kayıtları say
+    _readSector = oldest;
+    _readSlot = 1;
+    uint32_t sector = oldest;
+    uint32_t slot = 1;
+    bool first = true;
+    while (flashNext(sector, slot, ev)) {
+        if (first) {
+            _readSector = sector;
+            _readSlot = slot;
+            first = false;
+        }
+        _flashCount++;
+        slot++;
+    }
+    
+    if (first) {
+        _readSector = _writeSector;
+        _readSlot = _writeSlot;
+    }
+}
+
+bool TelemetryQueue::openSector(uint32_t sector) {
+    if (esp_partition_erase_range(_part, sector * SECTOR_SIZE, SECTOR_SIZE) != ESP_OK) {
+        DEBUG_PRINTF("[Queue] Sector %u erase failed\n", sector);
+        return false;
+    }
+    
+    SectorHeader hdr;
+    memset(&hdr, 0xFF, sizeof(hdr));
+    hdr.magic = SECTOR_MAGIC;
+    hdr.seq = ++_seq;
+    
+    return esp_partition_write(_part, sector * SECTOR_SIZE, &hdr, sizeof(hdr)) == ESP_OK;
+}
+
+uint32_t TelemetryQueue::slotOffset(uint32_t sector, uint32_t slot) {
+    return sector * SECTOR_SIZE + slot * sizeof(RelayEvent);
+}
+
+uint16_t TelemetryQueue::crc16(const RelayEvent& ev) {
+    // CRC-16/CCITT - marker ve crc alanları hariç
+    const uint8_t* p = (const uint8_t*)&ev;
+    size_t len = offsetof(RelayEvent, marker);
+    uint16_t crc = 0xFFFF;
+    
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)p[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
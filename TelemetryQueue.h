@@ -0,0 +1,77 @@
+#ifndef TELEMETRY_QUEUE_H
+#define TELEMETRY_QUEUE_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "Config.h"
+
+// Bağlantı yokken oluşan röle olayları.
+// Zaman damgası SNTP senkronize ise epoch ms, değilse uptime ms (EVENT_TS_EPOCH yok);
+// uptime damgaları aynı açılışta gönderilirken epoch'a çevrilir.
+#define EVENT_TS_EPOCH      0x01
+
+struct RelayEvent {
+    uint64_t ts;
+    uint16_t bootId;    // Uptime damgalarının hangi açılışa ait olduğu
+    uint8_t changed;    // Değişen kanallar (bitmask)
+    uint8_t states;     // Olay anındaki tüm kanal durumları (bitmask)
+    uint8_t flags;
+    uint8_t marker;     // Flash kaydı durumu (RAM'de kullanılmaz)
+    uint16_t crc;
+};
+
+// Sınırlı halka tampon (PSRAM) + opsiyonel flash taşma alanı.
+// En eski kayıtlar önce: flash, sonra RAM.
+class TelemetryQueue {
+public:
+    TelemetryQueue();
+    
+    void begin();
+    
+    void push(uint8_t changed, uint8_t states);
+    size_t peek(RelayEvent* out, size_t max);   // En eski kayıtları kopyalar, silmez
+    void pop(size_t count);                      // peek() ile alınanları onayla
+    
+    size_t size();
+    bool isEmpty();
+    uint32_t getDropped();
+    
+    // Uptime damgasını epoch ms'ye çevirir; çevrilemezse false
+    bool resolveTimestamp(const RelayEvent& ev, uint64_t& epochMs);
+    static bool timeValid();
+    static uint64_t epochMs();
+
+private:
+    // RAM halkası
+    RelayEvent* _ring;
+    size_t _capacity;
+    size_t _head;       // En eski kayıt
+    size_t _count;
+    
+    uint16_t _bootId;
+    uint32_t _dropped;
+    
+    // Flash taşma alanı
+    const esp_partition_t* _part;
+    uint32_t _sectorCount;
+    uint32_t _seq;          // Son açılan sektörün sıra numarası
+    uint32_t _writeSector;
+    uint32_t _writeSlot;
+    uint32_t _readSector;
+    uint32_t _readSlot;
+    size_t _flashCount;
+    
+    void spill();
+    bool flashAppend(const RelayEvent& ev);
+    bool flashRead(uint32_t sector, uint32_t slot, RelayEvent& ev);
+    void flashConsume(uint32_t sector, uint32_t slot);
+    void flashScan();
+    bool openSector(uint32_t sector);
+    bool flashNext(uint32_t& sector, uint32_t& slot, RelayEvent& ev);
+    uint32_t slotOffset(uint32_t sector, uint32_t slot);
+    static uint16_t crc16(const RelayEvent& ev);
+};
+
+extern TelemetryQueue Backlog;
+
+#endif // TELEMETRY_QUEUE_H
@@ -1,12 +1,81 @@
 #include "ThingsBoardMQTT.h"
+#include "RelayJournal.h"
+#include "EventLoop.h"
+#include "WiFiLink.h"
+#include "PerfStats.h"
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
 
 ThingsBoardMQTT TB;
 ThingsBoardMQTT* ThingsBoardMQTT::_instance = nullptr;
 
-ThingsBoardMQTT::ThingsBoardMQTT() : _mqttClient(_wifiClient) {
+// Protobuf cihaz profilinin telemetry, attribute ve RPC yanıt şeması (README'deki
+// DeviceMsg). Sık gönderilen alanlar 1..15: tek baytlık tag.
+static const ProtoField PROTO_SCHEMA[] = {
+    { "relay1", 1, ProtoType::BOOL },
+    { "relay2", 2, ProtoType::BOOL },
+    { "relay3", 3, ProtoType::BOOL },
+    { "relay4", 4, ProtoType::BOOL },
+    { "relay5", 5, ProtoType::BOOL },
+    { "relay6", 6, ProtoType::BOOL },
+    { "rssi", 7, ProtoType::SINT32 },
+    { "free_heap", 8, ProtoType::UINT32 },
+    { "uptime", 9, ProtoType::UINT32 },
+    { "error", 10, ProtoType::STRING },
+    { "status", 11, ProtoType::STRING },
+    { "firmware", 12, ProtoType::STRING },
+    { "device_type", 13, ProtoType::STRING },
+    { "ip", 14, ProtoType::STRING },
+    { "mac", 15, ProtoType::STRING },
+    { "relay_count", 16, ProtoType::UINT32 },
+    { "connect_ms", 17, ProtoType::UINT32 },
+    { "tls", 18, ProtoType::BOOL },
+    { "tls_handshake_ms", 19, ProtoType::UINT32 },
+    { "tls_full_ms", 20, ProtoType::UINT32 },
+    { "tls_resumed_ms", 21, ProtoType::UINT32 },
+    { "tls_resumed", 22, ProtoType::BOOL },
+    { "tls_resume_hits", 23, ProtoType::UINT32 },
+    { "tls_resume_attempts", 24, ProtoType::UINT32 },
+    { "tls_failures", 25, ProtoType::UINT32 },
+    { "tls_resume_rate", 26, ProtoType::FLOAT },
+    { "wifi_connect_ms", 27, ProtoType::UINT32 },
+    { "wifi_fast", 28, ProtoType::BOOL },
+};
+
+ThingsBoardMQTT::ThingsBoardMQTT() : _mqttClient(_transport) {
     _lastTelemetryTime = 0;
-    _lastReconnectAttempt = 0;
+    _protobuf = false;
+    _dirtyMask = 0;
+    _lastFlushTime = 0;
+    _lastDrainTime = 0;
+    _lastRssi = 0;
+    _lastFreeHeap = 0;
+    _lastAttrSentTime = 0;
+    _lastAttrCheckTime = 0;
+    _connState = MQTTConnState::IDLE;
+    _stepStartedAt = 0;
+    _backoffUntil = 0;
+    _backoffMs = MQTT_BACKOFF_MIN_MS;
+    _everConnected = false;
+    _subacksPending = 0;
+    _transportReady = false;
+    _attemptStartedAt = 0;
+    _lastConnectMs = 0;
+    _attrRequestId = 0;
+    _attrRequestPending = false;
+    _desiredMask = 0;
+    _desiredStates = 0;
+    _desiredLoaded = false;
+    _dnsDone = false;
+    _dnsAddr = 0;
+    _dnsGeneration = 0;
+    _restartAt = 0;
+    _restartPending = false;
+    _restartResetConfig = false;
+    memcpy(_rpcResponseTopic, TB_RPC_RESPONSE_TOPIC, sizeof(TB_RPC_RESPONSE_TOPIC));
     _instance = this;
+    
+    registerBuiltinRpcs();
 }
 
 void ThingsBoardMQTT::begin() {
@@ -16,63 +85,123 @@ void ThingsBoardMQTT::begin() {
     
     _mqttClient.setServer(cfg.tbServer, cfg.tbPort);
     _mqttClient.setCallback(staticCallback);
-    _mqttClient.setBufferSize(512);
+    _mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+    setupTransport();
+    _protobuf = cfg.tbProto;
+    
+    DEBUG_PRINTF("[TB] Server: %s:%d%s%s\n", cfg.tbServer, cfg.tbPort,
+                 cfg.tbTls ? " (TLS)" : "", _protobuf ? " (protobuf)" : "");
     
-    DEBUG_PRINTF("[TB] Server: %s:%d\n", cfg.tbServer, cfg.tbPort);
+    connect();
 }
 
 void ThingsBoardMQTT::loop() {
-    if (!_mqttClient.connected()) {
-        unsigned long now = millis();
-        if (now - _lastReconnectAttempt > MQTT_RECONNECT_DELAY_MS) {
-            _lastReconnectAttempt = now;
-            DEBUG_PRINTLN("[TB] Attempting MQTT reconnect...");
-            if (connect()) {
-                _lastReconnectAttempt = 0;
+    // reboot / resetConfig RPC'si: yanıt gönderildi, kısa süre sonra yeniden başlat
+    if (_restartPending) {
+        if ((long)(millis() - _restartAt) >= 0) {
+            Journal.flush();
+            if (_restartResetConfig) {
+                Config.resetConfig();
             }
+            ESP.restart();
         }
-    } else {
-        _mqttClient.loop();
+        Events.dueAt(_restartAt);
+    }
+    
+    if (_connState != MQTTConnState::CONNECTED) {
+        stepConnect();
         
-        // Periyodik telemetry
-        unsigned long now = millis();
-        if (now - _lastTelemetryTime > TELEMETRY_INTERVAL_MS) {
-            _lastTelemetryTime = now;
-            sendTelemetry();
-            sendAttributes();
+        // Backoff süresince uyunur; diğer adımlar (TCP, TLS, CONNACK) yoklanır
+        if (_connState == MQTTConnState::BACKOFF) {
+            Events.dueAt(_backoffUntil);
+        } else if (_connState != MQTTConnState::IDLE && _connState != MQTTConnState::CONNECTED) {
+            Events.dueIn(LOOP_POLL_MS);
         }
+        return;
     }
-}
-
-bool ThingsBoardMQTT::connect() {
-    DeviceConfig& cfg = Config.getConfig();
     
-    if (strlen(cfg.tbToken) == 0) {
-        DEBUG_PRINTLN("[TB] No access token configured");
-        return false;
+    if (!_mqttClient.connected()) {
+        DEBUG_PRINTLN("[TB] Connection lost");
+        _transport.stop();
+        scheduleRetry(false);
+        return;
     }
     
-    DEBUG_PRINTF("[TB] Connecting as %s...\n", cfg.tbToken);
+    _mqttClient.loop();
     
-    // ThingsBoard: username = access token, password = null
-    String clientId = "ESP32_" + String((uint32_t)ESP.getEfuseMac(), HEX);
+    // Periyodik telemetry
+    unsigned long now = millis();
+    if (now - _lastTelemetryTime > TELEMETRY_INTERVAL_MS) {
+        _lastTelemetryTime = now;
+        sendTelemetry();
+    }
     
-    if (_mqttClient.connect(clientId.c_str(), cfg.tbToken, NULL)) {
-        DEBUG_PRINTLN("[TB] Connected!");
-        
-        // RPC request topic'ine subscribe ol
-        _mqttClient.subscribe(TB_RPC_REQUEST_TOPIC);
-        DEBUG_PRINTLN("[TB] Subscribed to RPC requests");
+    // Dinamik attribute'lar yalnızca değiştiğinde
+    if (now - _lastAttrCheckTime > ATTR_CHECK_INTERVAL_MS) {
+        _lastAttrCheckTime = now;
+        updateDynamicAttributes();
+    }
+    
+    if (_attrRequestPending) {
+        requestSharedAttributes();
+    }
+    
+    // Bu tick'te (RPC dahil) biriken röle değişikliklerini tek mesajda kuyruğa yaz
+    flushTelemetry();
+    flushTimerEvents();
+    
+    // Öncelik sırasıyla: RPC yanıtları, röle durumu, attribute'lar
+    drainOutbox();
+    
+    // Bağlantı yokken biriken olaylar - yalnızca kuyruk boşaldığında
+    if (_outbox.isEmpty()) {
+        drainBacklog();
+    }
+    
+    scheduleWakeup();
+}
+
+// Olay döngüsüne bir sonraki iş zamanı ve MQTT soketi
+void ThingsBoardMQTT::scheduleWakeup() {
+    // TLS gönderimi bekliyorsa soket yazılabilir olunca uyanılır
+    bool writeBlocked = _transport.writePending();
+    Events.watch(_transport.socketFd(), writeBlocked);
+    
+    // Kuyrukta kalan mesaj ya da soket dışında tamponlanmış veri: hemen yeni tur
+    if ((!_outbox.isEmpty() && !writeBlocked) || _transport.available() > 0) {
+        Events.dueIn(0);
+        return;
+    }
+    
+    Events.dueAt(_lastTelemetryTime + TELEMETRY_INTERVAL_MS + 1);
+    Events.dueAt(_lastAttrCheckTime + ATTR_CHECK_INTERVAL_MS + 1);
+    if (_dirtyMask != 0) {
+        Events.dueAt(_lastFlushTime + TELEMETRY_COALESCE_MS);
+    }
+    if (!Backlog.isEmpty() && TelemetryQueue::timeValid()) {
+        Events.dueAt(_lastDrainTime + TELEMETRY_DRAIN_INTERVAL_MS);
+    }
+}
+
+bool ThingsBoardMQTT::connect() {
+    if (_connState == MQTTConnState::IDLE) {
+        DeviceConfig& cfg = Config.getConfig();
         
-        // İlk telemetry gönder
-        sendTelemetry();
-        sendAttributes();
+        if (strlen(cfg.tbToken) == 0) {
+            DEBUG_PRINTLN("[TB] No access token configured");
+            return false;
+        }
         
-        return true;
-    } else {
-        DEBUG_PRINTF("[TB] Connection failed, rc=%d\n", _mqttClient.state());
-        return false;
+        // İlk bağlantı hemen, sonrakiler jitter ile (toplu yeniden bağlanmayı önler)
+        if (_everConnected) {
+            scheduleRetry(false);
+        } else {
+            enterStep(MQTTConnState::BACKOFF);
+            _backoffUntil = millis();
+        }
     }
+    
+    return isConnected();
 }
 
 void ThingsBoardMQTT::disconnect() {
@@ -80,76 +209,721 @@ void ThingsBoardMQTT::disconnect() {
         _mqttClient.disconnect();
         DEBUG_PRINTLN("[TB] Disconnected");
     }
+    _transport.stop();
+    _dnsGeneration++;
+    _connState = MQTTConnState::IDLE;
 }
 
 bool ThingsBoardMQTT::isConnected() {
-    return _mqttClient.connected();
+    return _connState == MQTTConnState::CONNECTED && _mqttClient.connected();
+}
+
+MQTTConnState ThingsBoardMQTT::getConnState() {
+    return _connState;
+}
+
+// ============================================
+// Bağlantı durum makinesi
+// Her çağrıda en fazla bir adım ilerler, hiçbir adım bloklamaz
+// ============================================
+
+void ThingsBoardMQTT::stepConnect() {
+    unsigned long now = millis();
+    
+    uint32_t timeout = _connState == MQTTConnState::TLS ? MQTT_TLS_TIMEOUT_MS : MQTT_STEP_TIMEOUT_MS;
+    if (_connState != MQTTConnState::IDLE && _connState != MQTTConnState::BACKOFF &&
+        now - _stepStartedAt > timeout) {
+        onConnectFailed("step timeout");
+        return;
+    }
+    
+    switch (_connState) {
+        case MQTTConnState::IDLE:
+        case MQTTConnState::CONNECTED:
+            break;
+        
+        case MQTTConnState::BACKOFF:
+            if ((long)(now - _backoffUntil) >= 0) {
+                startDNS();
+            }
+            break;
+        
+        case MQTTConnState::DNS:
+            if (_dnsDone) {
+                if (_dnsAddr == 0) {
+                    onConnectFailed("DNS lookup failed");
+                    return;
+                }
+                _serverIP = IPAddress(_dnsAddr);
+                DeviceConfig& cfg = Config.getConfig();
+                DEBUG_PRINTF("[TB] Resolved %s -> %s\n", cfg.tbServer, _serverIP.toString().c_str());
+                
+                if (!_transport.beginConnect(_serverIP, cfg.tbPort)) {
+                    onConnectFailed("socket error");
+                    return;
+                }
+                enterStep(MQTTConnState::TCP);
+            }
+            break;
+        
+        case MQTTConnState::TCP: {
+            TransportConnectResult res = _transport.pollConnect();
+            if (res == TransportConnectResult::FAILED) {
+                onConnectFailed("TCP connect failed");
+                return;
+            }
+            if (res == TransportConnectResult::PENDING) {
+                return;
+            }
+            
+            Link.confirmIp();   // Yerel IP / ağ geçidi çalışıyor
+            
+            if (_transport.isTls()) {
+                if (!_transport.beginHandshake(Config.getConfig().tbServer)) {
+                    onConnectFailed("TLS setup failed");
+                    return;
+                }
+                enterStep(MQTTConnState::TLS);
+                return;
+            }
+            
+            sendConnect();
+            break;
+        }
+        
+        case MQTTConnState::TLS: {
+            // Her çağrıda handshake'i bir uçuş ilerletir
+            TransportConnectResult res = _transport.pollHandshake();
+            if (res == TransportConnectResult::FAILED) {
+                onConnectFailed("TLS handshake failed");
+                return;
+            }
+            if (res == TransportConnectResult::PENDING) {
+                return;
+            }
+            
+            sendConnect();
+            break;
+        }
+        
+        case MQTTConnState::CONNACK: {
+            if (!_transport.connected()) {
+                onConnectFailed("socket closed");
+                return;
+            }
+            if (_transport.rawAvailable() < 4) {
+                return;
+            }
+            
+            uint8_t ack[4];
+            _transport.rawRead(ack, sizeof(ack));
+            if (ack[0] != 0x20 || ack[3] != 0) {
+                DEBUG_PRINTF("[TB] CONNACK refused, rc=%d\n", ack[3]);
+                onConnectFailed("CONNACK refused");
+                return;
+            }
+            
+            DEBUG_PRINTF("[TB] CONNACK ok, session present: %d\n", ack[2] & 0x01);
+            
+            // RPC istekleri, shared attribute güncellemeleri ve attribute yanıtları
+            if (!_mqttClient.subscribe(TB_RPC_REQUEST_TOPIC, MQTT_SUBSCRIBE_QOS) ||
+                !_mqttClient.subscribe(TB_ATTRIBUTES_TOPIC, MQTT_SUBSCRIBE_QOS) ||
+                !_mqttClient.subscribe(TB_ATTR_RESPONSE_TOPIC, MQTT_SUBSCRIBE_QOS)) {
+                onConnectFailed("SUBSCRIBE write failed");
+                return;
+            }
+            _subacksPending = 3;
+            enterStep(MQTTConnState::SUBACK);
+            break;
+        }
+        
+        case MQTTConnState::SUBACK: {
+            if (!_transport.connected()) {
+                onConnectFailed("socket closed");
+                return;
+            }
+            if (_transport.rawAvailable() == 0) {
+                return;
+            }
+            
+            // Kalıcı oturumda broker, bekleyen PUBLISH'leri SUBACK'lerden önce
+            // gönderebilir - SUBACK olmayan paketler PubSubClient'a bırakılır
+            if ((_transport.rawPeek() & 0xF0) != 0x90) {
+                _mqttClient.loop();
+                return;
+            }
+            if (_transport.rawAvailable() < 5) {
+                return;
+            }
+            
+            // SUBACK: 0x90, len 3, msgId (2), return code
+            uint8_t ack[5];
+            _transport.rawRead(ack, sizeof(ack));
+            if (ack[1] != 0x03 || ack[4] == 0x80) {
+                onConnectFailed("SUBACK refused");
+                return;
+            }
+            
+            if (--_subacksPending > 0) {
+                return;
+            }
+            
+            DEBUG_PRINTLN("[TB] Subscribed to RPC requests and shared attributes");
+            onConnected();
+            break;
+        }
+    }
+}
+
+void ThingsBoardMQTT::sendConnect() {
+    DeviceConfig& cfg = Config.getConfig();
+    DEBUG_PRINTF("[TB] Connecting as %s...\n", cfg.tbToken);
+    
+    // ThingsBoard: username = access token, password = null
+    // PubSubClient CONNECT'i yazar, sahte CONNACK ile hemen döner;
+    // gerçek CONNACK bir sonraki adımda non-blocking okunur
+    char clientId[24];
+    snprintf(clientId, sizeof(clientId), "ESP32_%x", (uint32_t)ESP.getEfuseMac());
+    
+    // Önceki bağlantıdan kalanlar eskidi; bağlanınca tam durum yeniden gönderilir.
+    // CONNACK / SUBACK beklerken (kalıcı oturum) gelen RPC'lerin yanıtları korunmalı
+    _outbox.clear();
+    
+    _transport.injectConnack();
+    if (!_mqttClient.connect(clientId, cfg.tbToken, NULL, NULL, 0, false, NULL, MQTT_CLEAN_SESSION)) {
+        onConnectFailed("CONNECT write failed");
+        return;
+    }
+    enterStep(MQTTConnState::CONNACK);
+}
+
+void ThingsBoardMQTT::setupTransport() {
+    // Bir kez: TLS oturumu WiFi kopmalarında da korunmalı (ayar değişince cihaz yeniden başlar)
+    if (_transportReady) return;
+    
+    DeviceConfig& cfg = Config.getConfig();
+    if (!cfg.tbTls) {
+        _transport.setTls(false, nullptr);
+        _transportReady = true;
+        return;
+    }
+    
+    // PEM yalnızca ayrıştırma süresince bellekte
+    char* ca = (char*)malloc(TB_CA_CERT_MAX_LEN);
+    if (ca != nullptr) {
+        Config.loadCaCert(ca, TB_CA_CERT_MAX_LEN);
+    }
+    
+    if (_transport.setTls(true, ca != nullptr ? ca : "")) {
+        _transportReady = true;
+    } else {
+        DEBUG_PRINTLN("[TB] TLS configuration failed");
+    }
+    free(ca);
+}
+
+void ThingsBoardMQTT::startDNS() {
+    DeviceConfig& cfg = Config.getConfig();
+    
+    if (!_transportReady) {
+        onConnectFailed("TLS not configured");
+        return;
+    }
+    
+    enterStep(MQTTConnState::DNS);
+    _attemptStartedAt = millis();
+    _dnsDone = false;
+    _dnsAddr = 0;
+    uint32_t generation = ++_dnsGeneration;
+    
+    ip_addr_t addr;
+    LOCK_TCPIP_CORE();
+    err_t err = dns_gethostbyname_addrtype(cfg.tbServer, &addr, dnsCallback,
+                                           (void*)(uintptr_t)generation, LWIP_DNS_ADDRTYPE_IPV4);
+    UNLOCK_TCPIP_CORE();
+    
+    if (err == ERR_OK) {
+        // IP adresi veya önbellekte - hemen hazır
+        _dnsAddr = ip_2_ip4(&addr)->addr;
+        _dnsDone = true;
+    } else if (err != ERR_INPROGRESS) {
+        _dnsDone = true;
+    }
+}
+
+void ThingsBoardMQTT::dnsCallback(const char* name, const ip_addr_t* ipaddr, void* arg) {
+    ThingsBoardMQTT* self = _instance;
+    if (!self || (uint32_t)(uintptr_t)arg != self->_dnsGeneration) {
+        return; // Eski (iptal edilmiş) sorgu
+    }
+    
+    self->_dnsAddr = (ipaddr && IP_IS_V4(ipaddr)) ? ip_2_ip4(ipaddr)->addr : 0;
+    self->_dnsDone = true;
+    Events.wake();  // tcpip task'ından
+}
+
+void ThingsBoardMQTT::enterStep(MQTTConnState state) {
+    _connState = state;
+    _stepStartedAt = millis();
+}
+
+void ThingsBoardMQTT::scheduleRetry(bool afterFailure) {
+    uint32_t delayMs;
+    
+    if (afterFailure) {
+        // Equal jitter: [backoff/2, backoff], sonra üstel artış
+        uint32_t half = _backoffMs / 2;
+        delayMs = half + esp_random() % (half + 1);
+        _backoffMs = min<uint32_t>(_backoffMs * 2, MQTT_BACKOFF_MAX_MS);
+    } else {
+        // Bağlantı koptu: tüm cihazlar aynı anda dönmesin diye [0, min) arası dağıt
+        delayMs = esp_random() % MQTT_BACKOFF_MIN_MS;
+    }
+    
+    DEBUG_PRINTF("[TB] Next attempt in %u ms\n", delayMs);
+    enterStep(MQTTConnState::BACKOFF);
+    _backoffUntil = millis() + delayMs;
+}
+
+void ThingsBoardMQTT::onConnectFailed(const char* reason) {
+    DEBUG_PRINTF("[TB] Connection failed (%s)\n", reason);
+    
+    _dnsGeneration++;
+    _transport.stop();
+    scheduleRetry(true);
+}
+
+void ThingsBoardMQTT::onConnected() {
+    DEBUG_PRINTLN("[TB] Connected!");
+    
+    _connState = MQTTConnState::CONNECTED;
+    _everConnected = true;
+    _backoffMs = MQTT_BACKOFF_MIN_MS;
+    _lastConnectMs = millis() - _attemptStartedAt;
+    
+    // İlk telemetry ve attribute'lar (statikler bu bağlantıda bir daha gönderilmez)
+    _lastTelemetryTime = millis();
+    _lastAttrCheckTime = millis();
+    sendTelemetry();
+    sendAttributes();
+    sendConnectionStats();
+    
+    // Kesinti sırasında değişmiş olabilecek istenen durumu al (kuyruk doluysa loop() yeniden dener)
+    _attrRequestPending = true;
+    requestSharedAttributes();
 }
 
 void ThingsBoardMQTT::sendTelemetry() {
     if (!_mqttClient.connected()) return;
     
-    String payload = Relays.getStatesJson();
+    // Tam durum gönderiliyor - bekleyen değişiklikler de kapsanır
+    _dirtyMask = 0;
     
-    if (_mqttClient.publish(TB_TELEMETRY_TOPIC, payload.c_str())) {
-        DEBUG_PRINTF("[TB] Telemetry sent: %s\n", payload.c_str());
+    if (enqueueRelayStates(0xFF, MERGE_FULL_STATE,
+                           PUBLISH_MERGE_BIT(MERGE_FULL_STATE) | PUBLISH_MERGE_BIT(MERGE_RELAY_DELTA))) {
+        DEBUG_PRINTF("[TB] Telemetry queued: 0x%02X\n", Relays.getStatesBitmask());
     } else {
-        DEBUG_PRINTLN("[TB] Telemetry send failed");
+        DEBUG_PRINTLN("[TB] Telemetry not queued");
     }
 }
 
-void ThingsBoardMQTT::sendTelemetry(const String& key, const String& value) {
-    if (!_mqttClient.connected()) return;
+void ThingsBoardMQTT::markRelaysDirty(uint8_t changed, uint8_t states) {
+    if (changed == 0) return;
+    _dirtyMask |= changed;
     
-    String payload = "{\"" + key + "\":\"" + value + "\"}";
-    _mqttClient.publish(TB_TELEMETRY_TOPIC, payload.c_str());
+    // Bağlantı yoksa olay zaman damgasıyla kuyruğa - yeniden bağlanınca gönderilir
+    if (!isConnected()) {
+        Backlog.push(changed, states);
+    }
 }
 
-void ThingsBoardMQTT::sendTelemetry(const String& key, float value) {
-    if (!_mqttClient.connected()) return;
+void ThingsBoardMQTT::flushTelemetry() {
+    if (_dirtyMask == 0 || !_mqttClient.connected()) return;
     
-    String payload = "{\"" + key + "\":" + String(value, 2) + "}";
-    _mqttClient.publish(TB_TELEMETRY_TOPIC, payload.c_str());
+    // İlk değişiklik hemen çıkar; pencere içindeki sonrakiler birikir
+    unsigned long now = millis();
+    if (now - _lastFlushTime < TELEMETRY_COALESCE_MS) return;
+    
+    // Geri basınç: kuyruk doluysa değişiklikler maskede birleşmeye devam eder
+    if (!_outbox.hasRoom(PublishPriority::STATE)) return;
+    
+    if (enqueueRelayStates(_dirtyMask, MERGE_RELAY_DELTA, 0)) {
+        DEBUG_PRINTF("[TB] Telemetry flushed: mask=0x%02X\n", _dirtyMask);
+        _dirtyMask = 0;
+        _lastFlushTime = now;
+    } else {
+        DEBUG_PRINTLN("[TB] Telemetry flush failed");
+    }
 }
 
-void ThingsBoardMQTT::sendTelemetry(const String& key, bool value) {
-    if (!_mqttClient.connected()) return;
+// {"ts":1718000000250,"values":{"auto_off":2}} - süre dolunca dönülen duruma göre auto_off / auto_on
+void ThingsBoardMQTT::flushTimerEvents() {
+    RelayTimerEvent ev;
+    
+    while (_outbox.hasRoom(PublishPriority::STATE) && Actuator.pollTimerEvent(ev)) {
+        char buf[JSON_BUFFER_SIZE];
+        JsonWriter json(buf, sizeof(buf));
+        json.beginObject();
+        
+        // Bağlantı yokken bekleyen olay da kendi anıyla damgalanır
+        if (TelemetryQueue::timeValid()) {
+            uint64_t ageMs = (esp_timer_get_time() - ev.at) / 1000;
+            json.add("ts", TelemetryQueue::epochMs() - ageMs);
+            json.beginObject("values");
+            json.add(ev.state ? "auto_on" : "auto_off", (int)ev.channel);
+            json.endObject();
+        } else {
+            json.add(ev.state ? "auto_on" : "auto_off", (int)ev.channel);
+        }
+        json.endObject();
+        
+        DEBUG_PRINTF("[TB] Relay %d timer expired, now %s\n", ev.channel, ev.state ? "ON" : "OFF");
+        enqueue(PublishPriority::STATE, TB_TELEMETRY_TOPIC, json);
+    }
+}
+
+void ThingsBoardMQTT::drainBacklog() {
+    if (Backlog.isEmpty() || !_mqttClient.connected()) return;
+    
+    // Uptime damgalı olaylar saat senkronize olana kadar bekler
+    if (!TelemetryQueue::timeValid()) return;
+    
+    unsigned long now = millis();
+    if (now - _lastDrainTime < TELEMETRY_DRAIN_INTERVAL_MS) return;
+    _lastDrainTime = now;
+    
+    RelayEvent events[TELEMETRY_BATCH_MAX_EVENTS];
+    BacklogBatch batch = { events, Backlog.peek(events, TELEMETRY_BATCH_MAX_EVENTS) };
+    size_t count = batch.count;
+    if (count == 0) return;
+    
+    // Damgalar akıştan önce bir kez çözülür - iki geçiş aynı çıktıyı üretmeli.
+    // Önceki açılıştan kalan, epoch'a çevrilemeyen olaylar atlanır.
+    bool hasEntries = false;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t ts;
+        if (Backlog.resolveTimestamp(events[i], ts)) {
+            events[i].ts = ts;
+            hasEntries = true;
+        } else {
+            events[i].changed = 0;
+        }
+    }
+    
+    if (hasEntries && !publishStream(TB_TELEMETRY_TOPIC, writeBacklogBatch, &batch)) {
+        DEBUG_PRINTLN("[TB] Backlog batch send failed");
+        return;
+    }
+    
+    Backlog.pop(count);
+    DEBUG_PRINTF("[TB] Backlog: sent %u events, %u left\n", (unsigned)count, (unsigned)Backlog.size());
+}
+
+// [{"ts":..,"values":{..}}, ...] - ts'ler drainBacklog'da epoch'a çevrildi
+void ThingsBoardMQTT::writeBacklogBatch(JsonWriter& json, void* ctx) {
+    const BacklogBatch* batch = static_cast<const BacklogBatch*>(ctx);
+    const RelayEvent* events = batch->events;
+    char key[8];
+    
+    json.beginArray();
+    for (size_t i = 0; i < batch->count; i++) {
+        if (events[i].changed == 0) continue;
+        
+        json.beginObject();
+        json.add("ts", (unsigned long long)events[i].ts);
+        json.beginObject("values");
+        for (int ch = 0; ch < RELAY_COUNT; ch++) {
+            if (!(events[i].changed & (1 << ch))) continue;
+            snprintf(key, sizeof(key), "relay%d", ch + 1);
+            json.add(key, (bool)(events[i].states & (1 << ch)));
+        }
+        json.endObject();
+        json.endObject();
+    }
+    json.endArray();
+}
+
+void ThingsBoardMQTT::sendTelemetry(const char* key, const char* value) {
+    // Dolu kuyrukta en eski atılır - bekleyen röle delta'sı yerine bu mesaj atlanır
+    if (!_mqttClient.connected() || !_outbox.hasRoom(PublishPriority::STATE)) return;
+    
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.add(key, value);
+    json.endObject();
+    enqueue(PublishPriority::STATE, TB_TELEMETRY_TOPIC, json);
+}
+
+void ThingsBoardMQTT::sendTelemetry(const char* key, float value) {
+    // Dolu kuyrukta en eski atılır - bekleyen röle delta'sı yerine bu mesaj atlanır
+    if (!_mqttClient.connected() || !_outbox.hasRoom(PublishPriority::STATE)) return;
+    
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.add(key, value, 2);
+    json.endObject();
+    enqueue(PublishPriority::STATE, TB_TELEMETRY_TOPIC, json);
+}
+
+void ThingsBoardMQTT::sendTelemetry(const char* key, bool value) {
+    // Dolu kuyrukta en eski atılır - bekleyen röle delta'sı yerine bu mesaj atlanır
+    if (!_mqttClient.connected() || !_outbox.hasRoom(PublishPriority::STATE)) return;
     
-    String payload = "{\"" + key + "\":" + (value ? "true" : "false") + "}";
-    _mqttClient.publish(TB_TELEMETRY_TOPIC, payload.c_str());
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.add(key, value);
+    json.endObject();
+    enqueue(PublishPriority::STATE, TB_TELEMETRY_TOPIC, json);
 }
 
 void ThingsBoardMQTT::sendAttributes() {
     if (!_mqttClient.connected()) return;
     
-    StaticJsonDocument<256> doc;
-    doc["firmware"] = FIRMWARE_VERSION;
-    doc["device_type"] = DEVICE_TYPE;
-    doc["ip"] = WiFi.localIP().toString();
-    doc["mac"] = WiFi.macAddress();
-    doc["rssi"] = WiFi.RSSI();
-    doc["uptime"] = millis() / 1000;
-    doc["free_heap"] = ESP.getFreeHeap();
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    writeDeviceInfo(json);
+    json.endObject();
+    
+    if (enqueue(PublishPriority::ATTRIBUTE, TB_ATTRIBUTES_TOPIC, json, MERGE_DEVICE_INFO,
+                PUBLISH_MERGE_BIT(MERGE_DEVICE_INFO))) {
+        DEBUG_PRINTF("[TB] Attributes queued: %s\n", buf);
+        _lastRssi = WiFi.RSSI();
+        _lastFreeHeap = ESP.getFreeHeap();
+        _lastAttrSentTime = millis();
+    }
+}
+
+void ThingsBoardMQTT::updateDynamicAttributes() {
+    if (!_mqttClient.connected()) return;
+    
+    int8_t rssi = WiFi.RSSI();
+    uint32_t freeHeap = ESP.getFreeHeap();
+    bool expired = millis() - _lastAttrSentTime >= ATTR_MAX_AGE_MS;
+    
+    bool rssiChanged = expired || abs(rssi - _lastRssi) >= ATTR_RSSI_DELTA_DBM;
+    bool heapChanged = expired || abs((int32_t)(freeHeap - _lastFreeHeap)) >= ATTR_HEAP_DELTA_BYTES;
     
-    String payload;
-    serializeJson(doc, payload);
+    if (!rssiChanged && !heapChanged) return;
     
-    if (_mqttClient.publish(TB_ATTRIBUTES_TOPIC, payload.c_str())) {
-        DEBUG_PRINTF("[TB] Attributes sent: %s\n", payload.c_str());
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    if (rssiChanged) json.add("rssi", (int)rssi);
+    if (heapChanged) json.add("free_heap", freeHeap);
+    if (expired) json.add("uptime", millis() / 1000);
+    json.endObject();
+    
+    if (enqueue(PublishPriority::ATTRIBUTE, TB_ATTRIBUTES_TOPIC, json)) {
+        DEBUG_PRINTF("[TB] Dynamic attributes queued: %s\n", buf);
+        if (rssiChanged) _lastRssi = rssi;
+        if (heapChanged) _lastFreeHeap = freeHeap;
+        if (expired) _lastAttrSentTime = millis();
     }
 }
 
-void ThingsBoardMQTT::sendAttribute(const String& key, const String& value) {
+void ThingsBoardMQTT::sendAttribute(const char* key, const char* value) {
     if (!_mqttClient.connected()) return;
     
-    String payload = "{\"" + key + "\":\"" + value + "\"}";
-    _mqttClient.publish(TB_ATTRIBUTES_TOPIC, payload.c_str());
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.add(key, value);
+    json.endObject();
+    enqueue(PublishPriority::ATTRIBUTE, TB_ATTRIBUTES_TOPIC, json);
 }
 
 bool ThingsBoardMQTT::publish(const char* topic, const char* payload) {
     return _mqttClient.publish(topic, payload);
 }
 
+bool ThingsBoardMQTT::publish(const char* topic, const JsonWriter& json) {
+    if (json.overflowed()) {
+        DEBUG_PRINTF("[TB] Payload too large for %s, dropped\n", topic);
+        return false;
+    }
+    return _mqttClient.publish(topic, (const uint8_t*)json.c_str(), json.length(), false);
+}
+
+bool ThingsBoardMQTT::publish(const char* topic, const ProtoWriter& proto) {
+    if (proto.overflowed()) {
+        DEBUG_PRINTF("[TB] Payload too large for %s, dropped\n", topic);
+        return false;
+    }
+    return _mqttClient.publish(topic, proto.data(), proto.length(), false);
+}
+
+// İki geçiş: önce uzunluk sayılır (MQTT başlığı için gerekli), sonra aynı
+// çıktı küçük parçalar halinde doğrudan sokete yazılır.
+bool ThingsBoardMQTT::publishStream(const char* topic, JsonProducer producer, void* ctx) {
+    if (!_mqttClient.connected()) return false;
+    
+    char chunk[MQTT_STREAM_CHUNK_SIZE];
+    JsonWriter counter(chunk, sizeof(chunk), countSink, nullptr);
+    producer(counter, ctx);
+    counter.flush();
+    if (counter.overflowed()) {
+        DEBUG_PRINTF("[TB] Stream payload for %s invalid\n", topic);
+        return false;
+    }
+    
+    StreamState state = { &_mqttClient, counter.length() };
+    if (!_mqttClient.beginPublish(topic, state.remaining, false)) {
+        return false;
+    }
+    
+    JsonWriter json(chunk, sizeof(chunk), streamSink, &state);
+    producer(json, ctx);
+    json.flush();
+    
+    // Uzunluk başlıkta yazıldı: eksik kalırsa boşlukla tamamlanır (geçerli JSON
+    // boşluğu), fazlası streamSink'te kesilir - MQTT akışı bozulmaz
+    bool complete = !json.overflowed() && state.remaining == 0;
+    static const char pad[8] = { ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ' };
+    while (state.remaining > 0) {
+        size_t n = min(state.remaining, sizeof(pad));
+        if (_mqttClient.write((const uint8_t*)pad, n) != n) break;
+        state.remaining -= n;
+    }
+    
+    if (!_mqttClient.endPublish() || !complete) {
+        DEBUG_PRINTF("[TB] Stream publish to %s failed\n", topic);
+        return false;
+    }
+    DEBUG_PRINTF("[TB] Streamed %u bytes to %s\n", (unsigned)counter.length(), topic);
+    return true;
+}
+
+bool ThingsBoardMQTT::countSink(void* ctx, const char* data, size_t len) {
+    return true;
+}
+
+bool ThingsBoardMQTT::streamSink(void* ctx, const char* data, size_t len) {
+    StreamState* state = static_cast<StreamState*>(ctx);
+    if (len > state->remaining) {
+        return false;   // Producer ilk geçişten farklı çıktı üretti
+    }
+    size_t written = state->client->write((const uint8_t*)data, len);
+    state->remaining -= written;
+    return written == len;
+}
+
+bool ThingsBoardMQTT::outboxIdle() {
+    return _outbox.isEmpty() && !_transport.writePending();
+}
+
+bool ThingsBoardMQTT::enqueueRelayStates(uint8_t mask, uint8_t mergeKey, uint8_t replaces) {
+    if (_protobuf) {
+        uint8_t buf[JSON_BUFFER_SIZE];
+        ProtoWriter proto(buf, sizeof(buf));
+        Relays.writeStatesProto(proto, mask);
+        return _outbox.push(PublishPriority::STATE, TB_TELEMETRY_TOPIC, proto.data(), proto.length(), mergeKey, replaces);
+    }
+    
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    Relays.writeStatesJson(json, mask);
+    json.endObject();
+    return enqueue(PublishPriority::STATE, TB_TELEMETRY_TOPIC, json, mergeKey, replaces);
+}
+
+// Protobuf modunda düz JSON şemaya göre çevrilir. Şemada olmayan anahtarlar
+// (ör. modüllerin kendi RPC'leri) JSON olarak gider - cihaz profilinde
+// "Enable compatibility with other payload formats" açık olmalı.
+bool ThingsBoardMQTT::enqueue(PublishPriority priority, const char* topic, const JsonWriter& json,
+                              uint8_t mergeKey, uint8_t replaces) {
+    if (json.overflowed()) {
+        DEBUG_PRINTF("[TB] Payload too large for %s, dropped\n", topic);
+        return false;
+    }
+    
+    if (_protobuf) {
+        StaticJsonDocument<PROTO_TRANSCODE_CAPACITY> doc;
+        if (!deserializeJson(doc, json.c_str(), json.length())) {
+            uint8_t buf[JSON_BUFFER_SIZE];
+            ProtoWriter proto(buf, sizeof(buf));
+            if (proto.addJson(doc.as<JsonObjectConst>(), PROTO_SCHEMA, sizeof(PROTO_SCHEMA) / sizeof(PROTO_SCHEMA[0])) &&
+                !proto.overflowed()) {
+                return _outbox.push(priority, topic, proto.data(), proto.length(), mergeKey, replaces);
+            }
+        }
+    }
+    
+    return _outbox.push(priority, topic, (const uint8_t*)json.c_str(), json.length(), mergeKey, replaces);
+}
+
+// Öncelik sırasıyla; bütçe dolunca kalanlar sonraki tick'e (tick başına en az bir mesaj)
+void ThingsBoardMQTT::drainOutbox() {
+    // TLS: önceki paketin kalanı gitmeden yenisi yazılmaz
+    if (!_transport.flushPending()) return;
+    
+    size_t sent = 0;
+    const PublishMessage* msg;
+    
+    while ((msg = _outbox.front()) != nullptr) {
+        if (sent > 0 && sent + msg->length > PUBLISH_TICK_BYTES) break;
+        
+        if (!_mqttClient.publish(msg->topic, msg->payload, msg->length, false)) {
+            DEBUG_PRINTF("[TB] Publish to %s failed, will retry\n", msg->topic);
+            break;
+        }
+        sent += msg->length;
+        _outbox.pop();
+    }
+}
+
+void ThingsBoardMQTT::writeDeviceInfo(JsonWriter& json) {
+    writeStaticInfo(json);
+    json.add("rssi", (int)WiFi.RSSI());
+    json.add("uptime", millis() / 1000);
+    json.add("free_heap", ESP.getFreeHeap());
+}
+
+void ThingsBoardMQTT::sendConnectionStats() {
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    writeConnectionStats(json);
+    json.endObject();
+    
+    if (enqueue(PublishPriority::ATTRIBUTE, TB_ATTRIBUTES_TOPIC, json, MERGE_CONN_STATS,
+                PUBLISH_MERGE_BIT(MERGE_CONN_STATS))) {
+        DEBUG_PRINTF("[TB] Connection stats queued: %s\n", buf);
+    }
+}
+
+void ThingsBoardMQTT::writeConnectionStats(JsonWriter& json) {
+    json.add("connect_ms", _lastConnectMs);
+    Link.writeStats(json);
+    json.add("tls", _transport.isTls());
+    if (!_transport.isTls()) return;
+    
+    const TlsStats& tls = _transport.getTlsStats();
+    json.add("tls_handshake_ms", tls.lastHandshakeMs);
+    json.add("tls_full_ms", tls.lastFullMs);
+    json.add("tls_resumed_ms", tls.lastResumedMs);
+    json.add("tls_resumed", tls.lastResumed);
+    json.add("tls_resume_hits", tls.resumeHits);
+    json.add("tls_resume_attempts", tls.resumeAttempts);
+    json.add("tls_failures", tls.failures);
+    json.add("tls_resume_rate", tls.resumeAttempts ? 100.0f * tls.resumeHits / tls.resumeAttempts : 0.0f, 1);
+}
+
+void ThingsBoardMQTT::writeStaticInfo(JsonWriter& json) {
+    IPAddress ip = WiFi.localIP();
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    
+    json.add("firmware", FIRMWARE_VERSION);
+    json.add("device_type", DEVICE_TYPE);
+    json.addf("ip", "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    json.addf("mac", "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
 void ThingsBoardMQTT::staticCallback(char* topic, byte* payload, unsigned int length) {
     if (_instance) {
         _instance->onMessage(topic, payload, length);
@@ -158,130 +932,325 @@ void ThingsBoardMQTT::staticCallback(char* topic, byte* payload, unsigned int le
 
 void ThingsBoardMQTT::onMessage(char* topic, byte* payload, unsigned int length) {
     DEBUG_PRINTF("[TB] Message received on %s\n", topic);
-    
-    // Null-terminate payload
-    char message[length + 1];
-    memcpy(message, payload, length);
-    message[length] = '\0';
-    
-    DEBUG_PRINTF("[TB] Payload: %s\n", message);
-    
-    String topicStr = String(topic);
+    DEBUG_PRINTF("[TB] Payload: %.*s\n", (int)length, (const char*)payload);
     
     // RPC Request: v1/devices/me/rpc/request/{requestId}
-    if (topicStr.startsWith("v1/devices/me/rpc/request/")) {
-        int requestId = topicStr.substring(26).toInt();
-        
-        StaticJsonDocument<256> doc;
-        DeserializationError error = deserializeJson(doc, message);
-        
-        if (error) {
-            DEBUG_PRINTF("[TB] JSON parse error: %s\n", error.c_str());
+    static const size_t rpcPrefixLen = sizeof(TB_RPC_REQUEST_PREFIX) - 1;
+    static const size_t attrPrefixLen = sizeof(TB_ATTR_RESPONSE_PREFIX) - 1;
+    const char* requestId = nullptr;
+    
+    if (strncmp(topic, TB_RPC_REQUEST_PREFIX, rpcPrefixLen) == 0) {
+        // requestId yanıt topic'ine olduğu gibi kopyalanır - sayıya çevrilmez
+        requestId = topic + rpcPrefixLen;
+        size_t idLen = strspn(requestId, "0123456789");
+        if (idLen == 0 || idLen > RPC_REQUEST_ID_MAX_LEN || requestId[idLen] != '\0') {
+            DEBUG_PRINTLN("[TB] Invalid RPC request id");
             return;
         }
-        
-        handleRPCRequest(requestId, doc);
+    } else if (strcmp(topic, TB_ATTRIBUTES_TOPIC) != 0 &&
+               strncmp(topic, TB_ATTR_RESPONSE_PREFIX, attrPrefixLen) != 0) {
+        return;
+    }
+    
+    // Zero-copy: char* giriş ile string'ler payload içinde yerinde sonlandırılır.
+    // Payload PubSubClient tamponunda; bir sonraki publish onu ezer, bu yüzden
+    // doküman yalnızca yanıt gönderilene kadar kullanılır.
+    DeserializationError error = deserializeJson(_rxDoc, (char*)payload, length);
+    
+    if (error) {
+        DEBUG_PRINTF("[TB] JSON parse error: %s\n", error.c_str());
+        return;
+    }
+    
+    if (requestId != nullptr) {
+        handleRPCRequest(requestId, _rxDoc);
+    } else if (_rxDoc.containsKey("shared")) {
+        // Attribute isteği yanıtı: {"shared":{"relay1":true,...}}
+        applySharedAttributes(_rxDoc["shared"].as<JsonObjectConst>(), true);
+    } else {
+        // Shared attribute güncellemesi: {"relay1":true}
+        applySharedAttributes(_rxDoc.as<JsonObjectConst>(), false);
     }
 }
 
-void ThingsBoardMQTT::handleRPCRequest(int requestId, JsonDocument& doc) {
-    String method = doc["method"].as<String>();
+void ThingsBoardMQTT::handleRPCRequest(const char* requestId, JsonDocument& doc) {
+    const char* method = doc["method"] | "";
     
-    DEBUG_PRINTF("[TB] RPC method: %s, requestId: %d\n", method.c_str(), requestId);
+    DEBUG_PRINTF("[TB] RPC method: %s, requestId: %s\n", method, requestId);
     
-    String response;
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter response(buf, sizeof(buf));
+    int64_t t0 = PerfStats::now();
+    _rpc.dispatch(method, doc["params"], response);
+    Perf.record(PerfProbe::RPC_DISPATCH, t0);
     
-    // ========== setRelay ==========
-    // {"method":"setRelay","params":{"relay":1,"state":true}}
-    if (method == "setRelay") {
-        int relay = doc["params"]["relay"] | 0;
-        bool state = doc["params"]["state"] | false;
-        
-        if (relay >= 1 && relay <= RELAY_COUNT) {
-            Relays.setState(relay, state);
-            response = "{\"relay" + String(relay) + "\":" + (Relays.getState(relay) ? "true" : "false") + "}";
-            
-            // Telemetry güncelle
-            sendTelemetry();
-        } else {
-            response = "{\"error\":\"Invalid relay number\"}";
-        }
+    sendRPCResponse(requestId, response);
+}
+
+bool ThingsBoardMQTT::registerRpc(const RpcMethod& method, RpcHandler handler) {
+    return _rpc.registerRpc(method, handler);
+}
+
+void ThingsBoardMQTT::requestRestart(bool resetConfig) {
+    _restartPending = true;
+    _restartResetConfig = resetConfig;
+    _restartAt = millis() + RPC_RESTART_DELAY_MS;
+}
+
+// ============================================
+// Shared attribute'lar (istenen röle durumu)
+// ============================================
+
+void ThingsBoardMQTT::requestSharedAttributes() {
+    // Röle delta'larını kuyruktan itmemek için yer açılmasını bekle
+    if (!_outbox.hasRoom(PublishPriority::STATE)) return;
+    
+    char keys[RELAY_COUNT * 8];
+    size_t len = 0;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        len += snprintf(keys + len, sizeof(keys) - len, "%srelay%d", i ? "," : "", i + 1);
     }
-    // ========== toggleRelay ==========
-    // {"method":"toggleRelay","params":{"relay":1}}
-    else if (method == "toggleRelay") {
-        int relay = doc["params"]["relay"] | 0;
-        
-        if (relay >= 1 && relay <= RELAY_COUNT) {
-            Relays.toggle(relay);
-            response = "{\"relay" + String(relay) + "\":" + (Relays.getState(relay) ? "true" : "false") + "}";
-            
-            sendTelemetry();
-        } else {
-            response = "{\"error\":\"Invalid relay number\"}";
+    
+    char buf[JSON_BUFFER_SIZE];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.add("sharedKeys", keys);
+    json.endObject();
+    
+    char topic[sizeof(TB_ATTR_REQUEST_TOPIC) + 10];
+    snprintf(topic, sizeof(topic), "%s%u", TB_ATTR_REQUEST_TOPIC, ++_attrRequestId);
+    
+    if (enqueue(PublishPriority::STATE, topic, json)) {
+        DEBUG_PRINTF("[TB] Shared attributes requested: %s\n", buf);
+        _attrRequestPending = false;
+    } else {
+        DEBUG_PRINTLN("[TB] Shared attribute request not queued");
+    }
+}
+
+// Yalnızca istenen değeri gerçekten değişen kanallar uygulanır: yeniden bağlanma
+// yanıtında son uygulanan değerle aynı olan anahtarlar atlanır, böylece arada
+// RPC / Modbus / zamanlayıcıyla yapılan değişiklikler eski attribute ile geri alınmaz.
+// Push güncellemesi (attribute sunucuda yazıldı) aynı değer olsa da uygulanır.
+void ThingsBoardMQTT::applySharedAttributes(JsonObjectConst attrs, bool onlyChanged) {
+    if (!_desiredLoaded) {
+        uint16_t desired = Config.loadDesiredRelays();
+        _desiredMask = desired >> 8;
+        _desiredStates = desired & 0xFF;
+        _desiredLoaded = true;
+    }
+    
+    uint8_t mask = 0;
+    uint8_t states = 0;
+    char key[8];
+    
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        snprintf(key, sizeof(key), "relay%d", i + 1);
+        JsonVariantConst value = attrs[key];
+        if (value.is<bool>() || value.is<int>()) {
+            mask |= (1 << i);
+            if (value.as<bool>()) {
+                states |= (1 << i);
+            }
         }
     }
-    // ========== setAllRelays ==========
-    // {"method":"setAllRelays","params":{"state":true}}
-    else if (method == "setAllRelays") {
-        bool state = doc["params"]["state"] | false;
-        Relays.setAll(state);
-        response = Relays.getStatesJson();
-        
-        sendTelemetry();
+    
+    if (mask == 0) return;
+    
+    uint8_t apply = mask;
+    if (onlyChanged) {
+        apply &= ~(_desiredMask & ~(_desiredStates ^ states));
     }
-    // ========== getRelayStates ==========
-    // {"method":"getRelayStates","params":{}}
-    else if (method == "getRelayStates") {
-        response = Relays.getStatesJson();
-    }
-    // ========== getDeviceInfo ==========
-    // {"method":"getDeviceInfo","params":{}}
-    else if (method == "getDeviceInfo") {
-        StaticJsonDocument<256> info;
-        info["firmware"] = FIRMWARE_VERSION;
-        info["device_type"] = DEVICE_TYPE;
-        info["ip"] = WiFi.localIP().toString();
-        info["mac"] = WiFi.macAddress();
-        info["rssi"] = WiFi.RSSI();
-        info["uptime"] = millis() / 1000;
-        info["free_heap"] = ESP.getFreeHeap();
-        info["relay_count"] = RELAY_COUNT;
-        serializeJson(info, response);
-    }
-    // ========== reboot ==========
-    // {"method":"reboot","params":{}}
-    else if (method == "reboot") {
-        response = "{\"status\":\"rebooting\"}";
-        sendRPCResponse(requestId, response);
-        delay(500);
-        ESP.restart();
+    DEBUG_PRINTF("[TB] Desired state: mask=0x%02X states=0x%02X, changed=0x%02X\n", mask, states, apply);
+    
+    // Uygulanamazsa kaydedilmez - bir sonraki yanıtta yeniden denenir
+    if (apply != 0 && !Actuator.setMask(RelaySource::NETWORK, apply, states)) {
+        DEBUG_PRINTLN("[TB] Desired state not applied, relay queue full");
         return;
     }
-    // ========== resetConfig ==========
-    // {"method":"resetConfig","params":{}}
-    else if (method == "resetConfig") {
-        response = "{\"status\":\"resetting\"}";
-        sendRPCResponse(requestId, response);
-        delay(500);
-        Config.resetConfig();
-        ESP.restart();
+    
+    uint8_t desiredMask = _desiredMask | mask;
+    uint8_t desiredStates = (_desiredStates & ~mask) | (states & mask);
+    if (desiredMask != _desiredMask || desiredStates != _desiredStates) {
+        _desiredMask = desiredMask;
+        _desiredStates = desiredStates;
+        Config.saveDesiredRelays((uint16_t)_desiredMask << 8 | _desiredStates);
+    }
+}
+
+// ============================================
+// Yerleşik RPC metotları
+// ============================================
+
+void ThingsBoardMQTT::registerBuiltinRpcs() {
+    _rpc.registerRpc(RPC_METHOD("setRelay"), rpcSetRelay);
+    _rpc.registerRpc(RPC_METHOD("toggleRelay"), rpcToggleRelay);
+    _rpc.registerRpc(RPC_METHOD("setAllRelays"), rpcSetAllRelays);
+    _rpc.registerRpc(RPC_METHOD("setRelays"), rpcSetRelays);
+    _rpc.registerRpc(RPC_METHOD("pulseRelay"), rpcPulseRelay);
+    _rpc.registerRpc(RPC_METHOD("setRelayTimed"), rpcSetRelayTimed);
+    _rpc.registerRpc(RPC_METHOD("getRelayStates"), rpcGetRelayStates);
+    _rpc.registerRpc(RPC_METHOD("getDeviceInfo"), rpcGetDeviceInfo);
+    _rpc.registerRpc(RPC_METHOD("getConnectionStats"), rpcGetConnectionStats);
+    _rpc.registerRpc(RPC_METHOD("reboot"), rpcReboot);
+    _rpc.registerRpc(RPC_METHOD("resetConfig"), rpcResetConfig);
+}
+
+// {"method":"setRelay","params":{"relay":1,"state":true}}
+void ThingsBoardMQTT::rpcSetRelay(JsonVariantConst params, JsonWriter& response) {
+    int relay = params["relay"] | 0;
+    bool state = params["state"] | false;
+    
+    if (relay < 1 || relay > RELAY_COUNT) {
+        response.add("error", "Invalid relay number");
         return;
     }
-    // ========== Unknown method ==========
-    else {
-        response = "{\"error\":\"Unknown method: " + method + "\"}";
+    
+    // Röle task'ına kuyruklanır; yanıt hedef durumu bildirir
+    if (!Actuator.setState(RelaySource::NETWORK, relay, state)) {
+        response.add("error", "Relay command queue full");
+        return;
     }
+    char key[8];
+    snprintf(key, sizeof(key), "relay%d", relay);
+    response.add(key, state);
+}
+
+// {"method":"toggleRelay","params":{"relay":1}}
+void ThingsBoardMQTT::rpcToggleRelay(JsonVariantConst params, JsonWriter& response) {
+    int relay = params["relay"] | 0;
     
-    sendRPCResponse(requestId, response);
+    if (relay < 1 || relay > RELAY_COUNT) {
+        response.add("error", "Invalid relay number");
+        return;
+    }
+    
+    bool target = !Relays.getState(relay);
+    if (!Actuator.toggle(RelaySource::NETWORK, relay)) {
+        response.add("error", "Relay command queue full");
+        return;
+    }
+    char key[8];
+    snprintf(key, sizeof(key), "relay%d", relay);
+    response.add(key, target);
+}
+
+// {"method":"setAllRelays","params":{"state":true}}
+void ThingsBoardMQTT::rpcSetAllRelays(JsonVariantConst params, JsonWriter& response) {
+    bool state = params["state"] | false;
+    if (!Actuator.setAll(RelaySource::NETWORK, state)) {
+        response.add("error", "Relay command queue full");
+        return;
+    }
+    RelayController::writeStatesJson(response, state ? 0xFF : 0x00, 0xFF);
+}
+
+// {"method":"setRelays","params":{"mask":5,"states":1}}
+// mask: etkilenen kanallar (bit 0 = relay1), states: bu kanalların hedef durumu
+void ThingsBoardMQTT::rpcSetRelays(JsonVariantConst params, JsonWriter& response) {
+    long mask = params["mask"] | -1L;
+    long states = params["states"] | -1L;
+    
+    if (mask <= 0 || mask > RELAY_ALL_MASK || states < 0 || states > RELAY_ALL_MASK) {
+        response.add("error", "Invalid mask or states");
+        return;
+    }
+    
+    if (!Actuator.setMask(RelaySource::NETWORK, (uint8_t)mask, (uint8_t)states)) {
+        response.add("error", "Relay command queue full");
+        return;
+    }
+    RelayController::writeStatesJson(response, (uint8_t)states, (uint8_t)mask);
+}
+
+// {"method":"pulseRelay","params":{"relay":1,"ms":250}}
+// Kapı otomatiği vb.: açar, ms sonra esp_timer ile kapatır
+void ThingsBoardMQTT::rpcPulseRelay(JsonVariantConst params, JsonWriter& response) {
+    int relay = params["relay"] | 0;
+    unsigned long ms = params["ms"] | 0UL;
+    
+    if (relay < 1 || relay > RELAY_COUNT) {
+        response.add("error", "Invalid relay number");
+        return;
+    }
+    if (ms == 0 || ms > RELAY_TIMER_MAX_MS) {
+        response.add("error", "Invalid duration");
+        return;
+    }
+    
+    if (!Actuator.pulse(RelaySource::NETWORK, relay, ms)) {
+        response.add("error", "Relay command queue full");
+        return;
+    }
+    char key[8];
+    snprintf(key, sizeof(key), "relay%d", relay);
+    response.add(key, true);
+    response.add("ms", ms);
+}
+
+// {"method":"setRelayTimed","params":{"relay":2,"state":true,"seconds":600}}
+// state true: süre boyunca açık (pompa), false: süre boyunca kapalı; sonra tersine döner
+void ThingsBoardMQTT::rpcSetRelayTimed(JsonVariantConst params, JsonWriter& response) {
+    int relay = params["relay"] | 0;
+    bool state = params["state"] | false;
+    unsigned long seconds = params["seconds"] | 0UL;
+    
+    if (relay < 1 || relay > RELAY_COUNT) {
+        response.add("error", "Invalid relay number");
+        return;
+    }
+    if (seconds == 0 || seconds > RELAY_TIMER_MAX_MS / 1000) {
+        response.add("error", "Invalid duration");
+        return;
+    }
+    
+    if (!Actuator.setTimed(RelaySource::NETWORK, relay, state, seconds * 1000)) {
+        response.add("error", "Relay command queue full");
+        return;
+    }
+    char key[8];
+    snprintf(key, sizeof(key), "relay%d", relay);
+    response.add(key, state);
+    response.add("seconds", seconds);
+}
+
+// {"method":"getRelayStates","params":{}}
+void ThingsBoardMQTT::rpcGetRelayStates(JsonVariantConst params, JsonWriter& response) {
+    Relays.writeStatesJson(response);
+}
+
+// {"method":"getDeviceInfo","params":{}}
+void ThingsBoardMQTT::rpcGetDeviceInfo(JsonVariantConst params, JsonWriter& response) {
+    TB.writeDeviceInfo(response);
+    response.add("relay_count", RELAY_COUNT);
+    response.add("relay_cmd_dropped", (unsigned long)Actuator.getDroppedCommands());    // Dolu kuyruk yüzünden reddedilen komutlar
+}
+
+// {"method":"getConnectionStats","params":{}}
+void ThingsBoardMQTT::rpcGetConnectionStats(JsonVariantConst params, JsonWriter& response) {
+    TB.writeConnectionStats(response);
+}
+
+// {"method":"reboot","params":{}}
+void ThingsBoardMQTT::rpcReboot(JsonVariantConst params, JsonWriter& response) {
+    response.add("status", "rebooting");
+    TB.requestRestart(false);
+}
+
+// {"method":"resetConfig","params":{}}
+void ThingsBoardMQTT::rpcResetConfig(JsonVariantConst params, JsonWriter& response) {
+    response.add("status", "resetting");
+    TB.requestRestart(true);
 }
 
-void ThingsBoardMQTT::sendRPCResponse(int requestId, const String& response) {
-    String topic = String(TB_RPC_RESPONSE_TOPIC) + String(requestId);
+void ThingsBoardMQTT::sendRPCResponse(const char* requestId, const JsonWriter& response) {
+    // Önek constructor'da yazıldı; requestId (doğrulanmış, sonlandırıcı dahil) arkasına
+    static const size_t prefixLen = sizeof(TB_RPC_RESPONSE_TOPIC) - 1;
+    memcpy(_rpcResponseTopic + prefixLen, requestId, strlen(requestId) + 1);
     
-    if (_mqttClient.publish(topic.c_str(), response.c_str())) {
-        DEBUG_PRINTF("[TB] RPC response sent to %s: %s\n", topic.c_str(), response.c_str());
+    if (enqueue(PublishPriority::RPC_RESPONSE, _rpcResponseTopic, response)) {
+        DEBUG_PRINTF("[TB] RPC response queued for %s: %s\n", _rpcResponseTopic, response.c_str());
     } else {
-        DEBUG_PRINTLN("[TB] RPC response send failed");
+        DEBUG_PRINTLN("[TB] RPC response dropped, outbox full");
     }
 }
@@ -5,9 +5,33 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <lwip/ip_addr.h>
 #include "Config.h"
 #include "ConfigManager.h"
 #include "RelayController.h"
+#include "RelayActuator.h"
+#include "MQTTTransport.h"
+#include "JsonWriter.h"
+#include "ProtoWriter.h"
+#include "PublishQueue.h"
+#include "TelemetryQueue.h"
+#include "RpcDispatcher.h"
+
+// Akışla gönderilen mesajın içeriğini yazar; publishStream iki kez çağırır
+// ve iki seferde de aynı çıktıyı üretmelidir (değerler önceden alınmalı)
+typedef void (*JsonProducer)(JsonWriter& json, void* ctx);
+
+// Non-blocking bağlantı adımları
+enum class MQTTConnState {
+    IDLE,       // Bağlantı istenmiyor
+    BACKOFF,    // Bir sonraki denemeyi bekliyor
+    DNS,        // Sunucu adı çözülüyor
+    TCP,        // TCP bağlantısı kuruluyor
+    TLS,        // TLS handshake (yalnızca TLS etkinse)
+    CONNACK,    // CONNECT gönderildi, CONNACK bekleniyor
+    SUBACK,     // SUBSCRIBE gönderildi, SUBACK bekleniyor
+    CONNECTED
+};
 
 class ThingsBoardMQTT {
 public:
@@ -16,34 +40,164 @@ public:
     void begin();
     void loop();
     
-    bool connect();
+    bool connect();     // Non-blocking: bağlantıyı başlatır, loop() ilerletir
     void disconnect();
     bool isConnected();
+    MQTTConnState getConnState();
     
     // Telemetry
     void sendTelemetry();
-    void sendTelemetry(const String& key, const String& value);
-    void sendTelemetry(const String& key, float value);
-    void sendTelemetry(const String& key, bool value);
+    void markRelaysDirty(uint8_t changed, uint8_t states);   // Değişen kanallar bir sonraki flush'ta gönderilir
+    void sendTelemetry(const char* key, const char* value);
+    void sendTelemetry(const char* key, float value);
+    void sendTelemetry(const char* key, bool value);
     
     // Attributes
-    void sendAttributes();
-    void sendAttribute(const String& key, const String& value);
+    void sendAttributes();              // Statik + dinamik, koşulsuz
+    void updateDynamicAttributes();     // Yalnızca eşiği aşan / süresi dolanlar
+    void sendAttribute(const char* key, const char* value);
+    
+    // RPC - diğer modüller kendi metotlarını ekleyebilir:
+    //   TB.registerRpc(RPC_METHOD("getSchedule"), handler);
+    bool registerRpc(const RpcMethod& method, RpcHandler handler);
+    void requestRestart(bool resetConfig);  // Yanıt gönderildikten sonra yeniden başlat
     
     // Manuel publish
     bool publish(const char* topic, const char* payload);
+    bool publish(const char* topic, const JsonWriter& json);
+    bool publish(const char* topic, const ProtoWriter& proto);
+    bool outboxIdle();  // Toplu mesajlar (gateway, sensör) yalnızca kuyruk boşken gönderilmeli
+    
+    // Büyük mesajlar: JSON doğrudan sokete yazılır, boyut MQTT tamponuyla
+    // sınırlı değildir; RAM kullanımı MQTT_STREAM_CHUNK_SIZE kadar
+    bool publishStream(const char* topic, JsonProducer producer, void* ctx);
 
 private:
-    WiFiClient _wifiClient;
+    MQTTTransport _transport;
     PubSubClient _mqttClient;
     
     unsigned long _lastTelemetryTime;
-    unsigned long _lastReconnectAttempt;
+    
+    // Protobuf cihaz profili: röle telemetry'si doğrudan, diğer düz mesajlar
+    // JSON'dan şemaya göre çevrilerek kuyruğa yazılır
+    bool _protobuf;
+    
+    // Giden kuyruk: çağıran hiçbir zaman sokete yazmaz, loop() bütçeyle boşaltır
+    enum MergeKey : uint8_t {
+        MERGE_NONE,
+        MERGE_FULL_STATE,   // Bekleyen tam durum ve delta'ların yerine geçer
+        MERGE_RELAY_DELTA,  // Birbirinin yerine geçmez (farklı kanallar)
+        MERGE_DEVICE_INFO,
+        MERGE_CONN_STATS
+    };
+    PublishQueue _outbox;
+    bool enqueue(PublishPriority priority, const char* topic, const JsonWriter& json,
+                 uint8_t mergeKey = MERGE_NONE, uint8_t replaces = 0);
+    bool enqueueRelayStates(uint8_t mask, uint8_t mergeKey, uint8_t replaces);
+    void drainOutbox();
+    
+    // Telemetry birleştirme: değişen kanallar tick başına tek mesajda
+    uint8_t _dirtyMask;
+    unsigned long _lastFlushTime;
+    void flushTelemetry();
+    void flushTimerEvents();    // Süreli modların auto-off / auto-on olayları
+    void scheduleWakeup();
+    
+    // Çevrimdışı biriken olayların batch gönderimi
+    unsigned long _lastDrainTime;
+    struct BacklogBatch {
+        RelayEvent* events;
+        size_t count;
+    };
+    void drainBacklog();
+    static void writeBacklogBatch(JsonWriter& json, void* ctx);
+    
+    // publishStream sink'leri
+    struct StreamState {
+        PubSubClient* client;
+        size_t remaining;   // Başlıkta bildirilen uzunluktan kalan
+    };
+    static bool countSink(void* ctx, const char* data, size_t len);
+    static bool streamSink(void* ctx, const char* data, size_t len);
+    
+    // Bağlantı durum makinesi
+    MQTTConnState _connState;
+    unsigned long _stepStartedAt;
+    unsigned long _backoffUntil;
+    uint32_t _backoffMs;
+    bool _everConnected;
+    uint8_t _subacksPending;
+    bool _transportReady;
+    
+    // Yeniden bağlanma süresi (DNS başlangıcından SUBACK'e)
+    unsigned long _attemptStartedAt;
+    uint32_t _lastConnectMs;
+    void sendConnectionStats();
+    void writeConnectionStats(JsonWriter& json);
+    
+    // Asenkron DNS (lwIP callback'i tcpip task'ında çalışır)
+    volatile bool _dnsDone;
+    volatile uint32_t _dnsAddr;
+    volatile uint32_t _dnsGeneration;
+    IPAddress _serverIP;
+    
+    void stepConnect();
+    void startDNS();
+    void setupTransport();
+    void sendConnect();
+    void enterStep(MQTTConnState state);
+    void scheduleRetry(bool afterFailure);
+    void onConnectFailed(const char* reason);
+    void onConnected();
+    static void dnsCallback(const char* name, const ip_addr_t* ipaddr, void* arg);
     
     void setupCallbacks();
     void onMessage(char* topic, byte* payload, unsigned int length);
-    void handleRPCRequest(int requestId, JsonDocument& doc);
-    void sendRPCResponse(int requestId, const String& response);
+    void handleRPCRequest(const char* requestId, JsonDocument& doc);
+    
+    // Gelen mesajlar PubSubClient'ın alım tamponundan yerinde parse edilir
+    StaticJsonDocument<RX_JSON_CAPACITY> _rxDoc;
+    
+    // Shared attribute'lar: relayN = istenen (desired) durum. Son uygulanan değerler
+    // NVS'te tutulur; yeniden bağlanma yanıtında yalnızca değişen anahtarlar uygulanır
+    uint32_t _attrRequestId;
+    bool _attrRequestPending;
+    uint8_t _desiredMask;
+    uint8_t _desiredStates;
+    bool _desiredLoaded;
+    void requestSharedAttributes();
+    void applySharedAttributes(JsonObjectConst attrs, bool onlyChanged);
+    
+    // Yanıt topic'i: sabit önek bir kez yazılır, yalnızca requestId eklenir
+    char _rpcResponseTopic[sizeof(TB_RPC_RESPONSE_TOPIC) + RPC_REQUEST_ID_MAX_LEN];
+    
+    RpcDispatcher _rpc;
+    unsigned long _restartAt;
+    bool _restartPending;
+    bool _restartResetConfig;
+    void registerBuiltinRpcs();
+    
+    // Yerleşik RPC metotları
+    static void rpcSetRelay(JsonVariantConst params, JsonWriter& response);
+    static void rpcToggleRelay(JsonVariantConst params, JsonWriter& response);
+    static void rpcSetAllRelays(JsonVariantConst params, JsonWriter& response);
+    static void rpcSetRelays(JsonVariantConst params, JsonWriter& response);
+    static void rpcPulseRelay(JsonVariantConst params, JsonWriter& response);
+    static void rpcSetRelayTimed(JsonVariantConst params, JsonWriter& response);
+    static void rpcGetRelayStates(JsonVariantConst params, JsonWriter& response);
+    static void rpcGetDeviceInfo(JsonVariantConst params, JsonWriter& response);
+    static void rpcGetConnectionStats(JsonVariantConst params, JsonWriter& response);
+    static void rpcReboot(JsonVariantConst params, JsonWriter& response);
+    static void rpcResetConfig(JsonVariantConst params, JsonWriter& response);
+    void sendRPCResponse(const char* requestId, const JsonWriter& response);
+    void writeDeviceInfo(JsonWriter& json);
+    void writeStaticInfo(JsonWriter& json);
+    
+    // Son gönderilen dinamik attribute değerleri
+    int8_t _lastRssi;
+    uint32_t _lastFreeHeap;
+    unsigned long _lastAttrSentTime;
+    unsigned long _lastAttrCheckTime;
     
     static ThingsBoardMQTT* _instance;
     static void staticCallback(char* topic, byte* payload, unsigned int length);
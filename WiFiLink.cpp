@@ -0,0 +1,181 @@
+#include "WiFiLink.h"
+#include "EventLoop.h"
+#include <lwip/etharp.h>
+#include <lwip/netif.h>
+#include <lwip/tcpip.h>
+
+WiFiLink Link;
+
+WiFiLink::WiFiLink() {
+    memset(&_cache, 0, sizeof(_cache));
+    _cacheLoaded = false;
+    _cacheValid = false;
+    _fast = false;
+    _fastFailed = false;
+    _attemptStart = 0;
+    _lastConnectMs = 0;
+    _lastFast = false;
+    _ipUnverified = false;
+    _probeCount = 0;
+    _probeAt = 0;
+}
+
+void WiFiLink::connect() {
+    if (!_cacheLoaded) {
+        _cacheValid = Config.loadWiFiCache(_cache);
+        _cacheLoaded = true;
+    }
+    
+    _attemptStart = millis();
+    
+    WiFi.mode(WIFI_STA);
+    WiFi.setSleep(POWER_SAVE_ENABLED && POWER_WIFI_MODEM_SLEEP ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE);
+    
+    if (_cacheValid && !_fastFailed) {
+        startFast();
+    } else {
+        startFull();
+    }
+}
+
+bool WiFiLink::poll() {
+    if (!_fast) return false;
+    
+    unsigned long deadline = _attemptStart + WIFI_FAST_CONNECT_TIMEOUT_MS;
+    if ((long)(millis() - deadline) < 0) {
+        Events.dueAt(deadline);
+        return false;
+    }
+    
+    // AP değişmiş / kanal kaymış olabilir - bu bağlantıda önbellek tekrar denenmez
+    DEBUG_PRINTLN("[WiFi] Fast connect timed out, falling back to scan + DHCP");
+    _fastFailed = true;
+    WiFi.disconnect();
+    startFull();
+    return true;
+}
+
+void WiFiLink::onConnected() {
+    _lastConnectMs = millis() - _attemptStart;
+    _lastFast = _fast;
+    _fast = false;
+    _fastFailed = false;
+    _ipUnverified = _lastFast && WIFI_CACHE_STATIC_IP;
+    _probeCount = 0;
+    _probeAt = millis();
+    
+    DEBUG_PRINTF("[WiFi] Associated in %u ms (%s)\n", _lastConnectMs, _lastFast ? "cached" : "scan");
+    
+    WiFiCache cache;
+    memset(&cache, 0, sizeof(cache));
+    memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+    cache.channel = WiFi.channel();
+    cache.ip = WiFi.localIP();
+    cache.gateway = WiFi.gatewayIP();
+    cache.subnet = WiFi.subnetMask();
+    cache.dns1 = WiFi.dnsIP(0);
+    cache.dns2 = WiFi.dnsIP(1);
+    
+    // Yalnızca değiştiğinde yaz (her yeniden bağlanmada NVS yazılmaz)
+    if (!_cacheValid || memcmp(&cache, &_cache, sizeof(cache)) != 0) {
+        _cache = cache;
+        _cacheValid = cache.channel != 0 && cache.ip != 0;
+        if (_cacheValid) {
+            Config.saveWiFiCache(_cache);
+            DEBUG_PRINTF("[WiFi] Cached AP %02X:%02X:%02X:%02X:%02X:%02X on channel %u\n",
+                         _cache.bssid[0], _cache.bssid[1], _cache.bssid[2],
+                         _cache.bssid[3], _cache.bssid[4], _cache.bssid[5], _cache.channel);
+        }
+    }
+}
+
+void WiFiLink::loop() {
+    if (!_ipUnverified) return;
+    
+    unsigned long now = millis();
+    if ((long)(now - _probeAt) < 0) {
+        Events.dueAt(_probeAt);
+        return;
+    }
+    
+    bool more = _probeCount < WIFI_GATEWAY_PROBE_TRIES;
+    if (probeGateway(more)) {
+        DEBUG_PRINTLN("[WiFi] Gateway answered ARP, cached IP kept");
+        _ipUnverified = false;
+        return;
+    }
+    if (!more) {
+        rejectIp();
+        return;
+    }
+    
+    _probeCount++;
+    _probeAt = now + WIFI_GATEWAY_PROBE_MS;
+    Events.dueAt(_probeAt);
+}
+
+void WiFiLink::confirmIp() {
+    _ipUnverified = false;
+}
+
+bool WiFiLink::probeGateway(bool request) {
+    ip4_addr_t gateway;
+    ip4_addr_set_u32(&gateway, (uint32_t)WiFi.gatewayIP());
+    uint32_t local = (uint32_t)WiFi.localIP();
+    bool found = false;
+    
+    // etharp tcpip çekirdeğine ait - kilitli çağrılır
+    LOCK_TCPIP_CORE();
+    struct netif* netif;
+    NETIF_FOREACH(netif) {
+        if (ip4_addr_get_u32(netif_ip4_addr(netif)) != local) continue;
+        
+        struct eth_addr* mac;
+        const ip4_addr_t* ip;
+        found = etharp_find_addr(netif, &gateway, &mac, &ip) >= 0;
+        if (!found && request) {
+            etharp_request(netif, &gateway);
+        }
+        break;
+    }
+    UNLOCK_TCPIP_CORE();
+    return found;
+}
+
+void WiFiLink::rejectIp() {
+    if (!_ipUnverified) return;
+    _ipUnverified = false;
+    
+    // Aynı IP her bağlanmada önbelleğe geri yazılmasın - DHCP yeni adres verir
+    DEBUG_PRINTLN("[WiFi] Gateway not answering ARP, clearing cache and reconnecting with DHCP");
+    Config.clearWiFiCache();
+    _cacheValid = false;
+    _fastFailed = true;
+    WiFi.disconnect();      // Durum makinesi WiFi kopmasını görüp yeniden bağlanır
+}
+
+void WiFiLink::writeStats(JsonWriter& json) {
+    json.add("wifi_connect_ms", _lastConnectMs);
+    json.add("wifi_fast", _lastFast);
+}
+
+void WiFiLink::startFast() {
+    DeviceConfig& cfg = Config.getConfig();
+    _fast = true;
+
+#if WIFI_CACHE_STATIC_IP
+    WiFi.config(IPAddress(_cache.ip), IPAddress(_cache.gateway), IPAddress(_cache.subnet),
+                IPAddress(_cache.dns1), IPAddress(_cache.dns2));
+#endif
+    WiFi.begin(cfg.wifiSsid, cfg.wifiPassword, _cache.channel, _cache.bssid);
+    Events.dueIn(WIFI_FAST_CONNECT_TIMEOUT_MS);
+}
+
+void WiFiLink::startFull() {
+    DeviceConfig& cfg = Config.getConfig();
+    _fast = false;
+    
+    // Önceki denemeden kalan statik IP'yi bırak - DHCP
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    WiFi.begin(cfg.wifiSsid, cfg.wifiPassword);
+}
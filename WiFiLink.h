@@ -0,0 +1,51 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "Config.h"
+#include "ConfigManager.h"
+#include "JsonWriter.h"
+
+// STA bağlantı denemeleri. Önbellekte son başarılı AP (BSSID, kanal) ve IP varsa
+// önce taramasız, DHCP'siz doğrudan bağlanılır; WIFI_FAST_CONNECT_TIMEOUT_MS içinde
+// olmazsa tam tarama + DHCP ile aynı deneme sürdürülür.
+class WiFiLink {
+public:
+    WiFiLink();
+    
+    void connect();             // Yeni deneme (Config.begin()'den sonra)
+    bool poll();                // Bağlanırken: true = hızlı deneme düştü, tam deneme başladı
+    void onConnected();         // IP alındı: süre ölçülür, önbellek güncellenir
+    
+    // Önbellekteki statik IP ile bağlanıldıysa IP yerel ağda doğrulanır: önbellekteki
+    // ağ geçidine ARP sorulur. Yanıt gelmezse IP eskimiş sayılır (ağ değişmiş,
+    // numaralandırma değişmiş), önbellek silinir ve WiFi DHCP ile yeniden bağlanır.
+    // Sunucu tarafındaki hatalar (DNS, TCP reddi / zaman aşımı) önbelleği silmez.
+    void loop();                // Bağlanırken: ARP denemesini ilerletir
+    void confirmIp();           // TCP bağlantısı kuruldu - ARP beklenmez
+    
+    void writeStats(JsonWriter& json);  // "wifi_connect_ms", "wifi_fast"
+
+private:
+    WiFiCache _cache;
+    bool _cacheLoaded;
+    bool _cacheValid;
+    bool _fast;                 // Sürmekte olan deneme önbellekli
+    bool _fastFailed;           // Bu bağlantı için önbellek denendi ve tutmadı
+    unsigned long _attemptStart;
+    uint32_t _lastConnectMs;
+    bool _lastFast;
+    bool _ipUnverified;         // Statik önbellek IP'si henüz doğrulanmadı
+    uint8_t _probeCount;        // Gönderilen ARP isteği
+    unsigned long _probeAt;     // Sonraki ARP kontrolü
+    
+    void startFull();
+    void startFast();
+    bool probeGateway(bool request);    // true: ağ geçidi ARP tablosunda
+    void rejectIp();
+};
+
+extern WiFiLink Link;
+
+#endif // WIFI_LINK_H
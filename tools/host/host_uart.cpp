@@ -0,0 +1,111 @@
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <freertos/task.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Modbus UART'ının host karşılığı: tek olay kuyruğu, tek port.
+// Donanımın RX timeout'u yerine HOST_UART_GAP_MS sessizlik çerçeveyi bitirir
+// (pty'de karakter süresi yok, USB adaptörlerinde gecikme toplanır).
+#define HOST_UART_GAP_MS    20
+#define HOST_UART_BUFFER    256     // MODBUS_UART_BUFFER
+
+static int uartFd = -1;
+static uint8_t rxBuf[HOST_UART_BUFFER];
+static size_t rxLen = 0;
+
+bool hostUartOpen(const char* path) {
+    uartFd = open(path, O_RDWR | O_NOCTTY);
+    if (uartFd < 0) {
+        perror(path);
+        return false;
+    }
+    
+    struct termios tio;
+    if (tcgetattr(uartFd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B9600);
+        tcsetattr(uartFd, TCSANOW, &tio);
+    }
+    return true;
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+    *previousWake += period;
+}
+
+// Gelen baytlar sessizliğe kadar toplanır, tek UART_DATA (timeout_flag) olayı olur
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait) {
+    uart_event_t* event = static_cast<uart_event_t*>(item);
+    if (uartFd < 0) return pdFALSE;
+    
+    struct pollfd pfd = { uartFd, POLLIN, 0 };
+    int timeout = wait == portMAX_DELAY ? -1 : (int)wait;
+    
+    rxLen = 0;
+    while (poll(&pfd, 1, timeout) > 0) {
+        ssize_t n = read(uartFd, rxBuf + rxLen, sizeof(rxBuf) - rxLen);
+        if (n <= 0) break;
+        rxLen += n;
+        if (rxLen == sizeof(rxBuf)) {
+            event->type = UART_BUFFER_FULL;
+            event->size = 0;
+            event->timeout_flag = false;
+            return pdTRUE;
+        }
+        timeout = HOST_UART_GAP_MS;
+    }
+    
+    if (rxLen == 0) return pdFALSE;
+    event->type = UART_DATA;
+    event->size = rxLen;
+    event->timeout_flag = true;
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    return pdPASS;
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rxSize, int txSize, int queueSize,
+                              QueueHandle_t* queue, int flags) {
+    *queue = &uartFd;
+    return uartFd >= 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* cfg) { return ESP_OK; }
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts) { return ESP_OK; }
+esp_err_t uart_set_mode(uart_port_t port, uart_mode_t mode) { return ESP_OK; }
+esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t symbols) { return ESP_OK; }
+esp_err_t uart_set_tx_idle_num(uart_port_t port, uint16_t bits) { return ESP_OK; }
+
+esp_err_t uart_flush_input(uart_port_t port) {
+    rxLen = 0;
+    if (uartFd >= 0) tcflush(uartFd, TCIFLUSH);
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t port, const void* data, size_t len) {
+    if (uartFd < 0) return -1;
+    ssize_t n = write(uartFd, data, len);
+    tcdrain(uartFd);
+    return (int)n;
+}
+
+int uart_read_bytes(uart_port_t port, void* buf, uint32_t len, TickType_t wait) {
+    size_t n = len < rxLen ? len : rxLen;
+    memcpy(buf, rxBuf, n);
+    memmove(rxBuf, rxBuf + n, rxLen - n);
+    rxLen -= n;
+    return (int)n;
+}
+
+const char* esp_err_to_name(esp_err_t err) {
+    return err == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
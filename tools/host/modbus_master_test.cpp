@@ -0,0 +1,216 @@
+// Modbus master'ın donanımsız host derlemesi. ModbusMaster.cpp / ModbusRTU.cpp
+// olduğu gibi derlenir; ağ tarafı (TB, Events, TelemetryQueue) aşağıdaki yerine
+// geçenlerle değiştirilir.
+//
+//   modbus_master_test                 # hazır yanıt çerçeveleriyle (ctest)
+//   modbus_master_test --port <tty>    # bir poll çevrimi tools/modbus-sim'e karşı
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include "../../Config.h"
+#include "../../JsonWriter.h"
+#include "../../ModbusRTU.h"
+#include "../../SpscQueue.h"
+
+// Gerçek başlıklar ESP32 ağ yığınını çeker - yerlerine yalnızca kullanılanlar
+#define THINGSBOARD_MQTT_H
+#define TELEMETRY_QUEUE_H
+#define EVENT_LOOP_H
+
+typedef void (*JsonProducer)(JsonWriter& json, void* ctx);
+
+static std::string lastTopic;
+static std::string lastPayload;
+
+class ThingsBoardMQTT {
+public:
+    bool outboxIdle() { return true; }
+    
+    bool publishStream(const char* topic, JsonProducer producer, void* ctx) {
+        char buf[1024];
+        JsonWriter json(buf, sizeof(buf));
+        producer(json, ctx);
+        lastTopic = topic;
+        lastPayload.assign(json.c_str(), json.length());
+        return !json.overflowed();
+    }
+};
+
+class TelemetryQueue {
+public:
+    static bool timeValid() { return true; }
+    static uint64_t epochMs() { return 1718000000000ULL; }
+};
+
+class EventLoop {
+public:
+    void wake() {}
+};
+
+ThingsBoardMQTT TB;
+EventLoop Events;
+
+// Poll tablosu, bloklar ve çevrim doğrudan sınanır
+#define private public
+#include "../../ModbusMaster.h"
+#undef private
+#include "../../ModbusMaster.cpp"
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } \
+} while (0)
+
+// ESP32_TB_Relay.ino'daki SDM120 tablosu, karışık sırada; slave 2 yalnızca hazır çerçevelerde
+static const ModbusPoint sdm120[] = {
+    { "SDM120-1", "frequency", 1, MODBUS_FC_READ_INPUT, 0x0046, ModbusType::F32, 1.0f },
+    { "SDM120-1", "power",     1, MODBUS_FC_READ_INPUT, 0x000C, ModbusType::F32, 1.0f },
+    { "SDM120-1", "voltage",   1, MODBUS_FC_READ_INPUT, 0x0000, ModbusType::F32, 1.0f },
+    { "SDM120-1", "current",   1, MODBUS_FC_READ_INPUT, 0x0006, ModbusType::F32, 1.0f },
+};
+
+static const ModbusPoint plc[] = {
+    { "PLC-1", "count", 2, MODBUS_FC_READ_HOLDING, 0x0011, ModbusType::U32, 1.0f },
+    { "PLC-1", "level", 2, MODBUS_FC_READ_HOLDING, 0x0010, ModbusType::S16, 0.1f },
+};
+
+// tools/modbus-sim/modbus_slave_sim.py yanıtları (CRC dahil)
+static const uint8_t plcReply[] = {
+    0x02, 0x03, 0x06, 0xFF, 0x38, 0x00, 0x01, 0xE2, 0x40, 0x98, 0xDF
+};
+static const uint8_t sdmReply[] = {
+    0x01, 0x04, 0x1C, 0x43, 0x66, 0x19, 0x9A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x3F, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x43, 0x8F,
+    0xCC, 0xCD, 0xFD, 0x61
+};
+static const uint8_t freqReply[] = {
+    0x01, 0x04, 0x04, 0x42, 0x48, 0x00, 0x00, 0x6F, 0xEA
+};
+static const uint8_t exceptionReply[] = {
+    0x01, 0x84, 0x02, 0xC2, 0xC1
+};
+
+static const char* expectedJson =
+    "{\"PLC-1\":[{\"ts\":1718000000000,\"values\":{\"level\":-20.000,\"count\":123456.000}}],"
+    "\"SDM120-1\":[{\"ts\":1718000000000,\"values\":{\"voltage\":230.100,\"current\":1.250,"
+    "\"power\":287.600,\"frequency\":50.000}}]}";
+
+static void testCrc() {
+    // Modbus spesifikasyonundaki örnek: 01 03 00 00 00 0A -> C5 CD
+    uint8_t frame[8] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A };
+    CHECK(modbusCrc16(frame, 6) == 0xCDC5);
+    CHECK(modbusAppendCrc(frame, 6) == 8);
+    CHECK(frame[6] == 0xC5 && frame[7] == 0xCD);
+    CHECK(modbusCheckCrc(frame, 8));
+    frame[3] ^= 1;
+    CHECK(!modbusCheckCrc(frame, 8));
+}
+
+static void testBlocks() {
+    ModbusMaster& m = Gateway;
+    CHECK(m._pointCount == 6);
+    
+    // Cihaz, slave, fonksiyon, adres sırası
+    const char* order[] = { "level", "count", "voltage", "current", "power", "frequency" };
+    for (size_t i = 0; i < m._pointCount; i++) {
+        CHECK(strcmp(m._points[i].key, order[i]) == 0);
+    }
+    
+    // PLC 0x10-0x12 tek blok; SDM 0x00-0x0D (boşluklar MODBUS_MAX_GAP_REGS içinde) ve 0x46 ayrı
+    CHECK(m._blockCount == 3);
+    CHECK(m._blocks[0].slaveId == 2 && m._blocks[0].start == 0x10 && m._blocks[0].count == 3);
+    CHECK(m._blocks[0].firstPoint == 0 && m._blocks[0].pointCount == 2);
+    CHECK(m._blocks[1].slaveId == 1 && m._blocks[1].start == 0x00 && m._blocks[1].count == 14);
+    CHECK(m._blocks[1].firstPoint == 2 && m._blocks[1].pointCount == 3);
+    CHECK(m._blocks[2].start == 0x46 && m._blocks[2].count == 2 && m._blocks[2].pointCount == 1);
+    
+    const uint8_t request[] = { 0x01, 0x04, 0x00, 0x00, 0x00, 0x0E };
+    CHECK(memcmp(m._blocks[1].request, request, sizeof(request)) == 0);
+    CHECK(modbusCheckCrc(m._blocks[1].request, sizeof(m._blocks[1].request)));
+}
+
+static void testValidate() {
+    ModbusMaster& m = Gateway;
+    uint8_t frame[sizeof(sdmReply)];
+    
+    CHECK(m.validate(m._blocks[0], plcReply, sizeof(plcReply)));
+    CHECK(m.validate(m._blocks[1], sdmReply, sizeof(sdmReply)));
+    CHECK(m.validate(m._blocks[2], freqReply, sizeof(freqReply)));
+    
+    CHECK(!m.validate(m._blocks[1], sdmReply, -1));                        // Zaman aşımı
+    CHECK(!m.validate(m._blocks[2], sdmReply, sizeof(sdmReply)));          // Başka bloğun yanıtı
+    CHECK(!m.validate(m._blocks[0], sdmReply, sizeof(sdmReply)));          // Başka slave
+    CHECK(!m.validate(m._blocks[1], exceptionReply, sizeof(exceptionReply)));
+    
+    memcpy(frame, sdmReply, sizeof(frame));
+    frame[10] ^= 0x40;
+    CHECK(!m.validate(m._blocks[1], frame, sizeof(frame)));                // CRC
+}
+
+static void testDecode() {
+    ModbusMaster& m = Gateway;
+    m._current.validMask = 0;
+    m.decode(m._blocks[0], plcReply);
+    m.decode(m._blocks[1], sdmReply);
+    m.decode(m._blocks[2], freqReply);
+    
+    CHECK(m._current.validMask == 0x3F);
+    CHECK(fabsf(m._current.values[0] - -20.0f) < 1e-4f);
+    CHECK(m._current.values[1] == 123456.0f);
+    CHECK(m._current.values[2] == 230.1f);
+    CHECK(m._current.values[3] == 1.25f);
+    CHECK(m._current.values[4] == 287.6f);
+    CHECK(m._current.values[5] == 50.0f);
+    
+    m._current.ts = TelemetryQueue::epochMs();
+    CHECK(m._cycles.push(m._current));
+    m.loop();
+    CHECK(lastTopic == TB_GATEWAY_TELEMETRY_TOPIC);
+    CHECK(lastPayload == expectedJson);
+    printf("%s\n", lastPayload.c_str());
+}
+
+// Bir poll çevrimi seri port üzerinden: SDM120 simülatörden okunur, PLC (slave 2)
+// yanıt vermez ve MODBUS_RESPONSE_TIMEOUT_MS sonra hata sayılır
+static int runOnPort(const char* path) {
+    if (!hostUartOpen(path)) return 1;
+    
+    ModbusMaster& m = Gateway;
+    m.sortPoints();
+    m.buildBlocks();
+    CHECK(modbusUartBegin(&m._uartQueue));
+    
+    m.pollCycle();
+    CHECK(m._requests == 3);
+    CHECK(m._errors == 1);
+    CHECK(m._current.validMask == 0x3C);
+    m.loop();
+    CHECK(lastPayload.find("\"SDM120-1\":[{\"ts\":1718000000000,\"values\":{\"voltage\":230.100,"
+                           "\"current\":1.250,\"power\":287.600,\"frequency\":50.000}}]") != std::string::npos);
+    printf("%s\n", lastPayload.c_str());
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    for (const ModbusPoint& p : sdm120) Gateway.addPoint(p);
+    for (const ModbusPoint& p : plc) Gateway.addPoint(p);
+    
+    if (argc == 3 && strcmp(argv[1], "--port") == 0) {
+        return runOnPort(argv[2]);
+    }
+    
+    testCrc();
+    Gateway.sortPoints();
+    Gateway.buildBlocks();
+    testBlocks();
+    testValidate();
+    testDecode();
+    
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    fprintf(stderr, "All checks passed\n");
+    return 0;
+}
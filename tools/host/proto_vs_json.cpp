@@ -0,0 +1,172 @@
+// README'deki örnek mesajların JSON ve protobuf boyutu ve kodlama süresi (host).
+// Kodlayıcılar cihazdakiyle aynıdır (JsonWriter.cpp, ProtoWriter.cpp); süreler
+// host CPU'sunda ölçülür - ESP32'de mutlak değerler değil oranlar anlamlıdır.
+//
+//   proto_vs_json [iterations]
+//
+// Cihaz dinamik attribute'ları JSON yazar, protobuf modunda ArduinoJson ile
+// çözüp şemaya göre çevirir. Bu yol yalnızca -DARDUINOJSON_DIR ile ölçülür.
+#include <Arduino.h>
+#include <chrono>
+#include "../../Config.h"
+#include "../../JsonWriter.h"
+#include "../../ProtoWriter.h"
+
+#ifndef HOST_ARDUINOJSON_STUB
+// ThingsBoardMQTT.cpp PROTO_SCHEMA ile aynı (addJson anahtarı sırayla arar)
+static const ProtoField PROTO_SCHEMA[] = {
+    { "relay1", 1, ProtoType::BOOL },
+    { "relay2", 2, ProtoType::BOOL },
+    { "relay3", 3, ProtoType::BOOL },
+    { "relay4", 4, ProtoType::BOOL },
+    { "relay5", 5, ProtoType::BOOL },
+    { "relay6", 6, ProtoType::BOOL },
+    { "rssi", 7, ProtoType::SINT32 },
+    { "free_heap", 8, ProtoType::UINT32 },
+    { "uptime", 9, ProtoType::UINT32 },
+    { "error", 10, ProtoType::STRING },
+    { "status", 11, ProtoType::STRING },
+    { "firmware", 12, ProtoType::STRING },
+    { "device_type", 13, ProtoType::STRING },
+    { "ip", 14, ProtoType::STRING },
+    { "mac", 15, ProtoType::STRING },
+    { "relay_count", 16, ProtoType::UINT32 },
+    { "connect_ms", 17, ProtoType::UINT32 },
+    { "tls", 18, ProtoType::BOOL },
+    { "tls_handshake_ms", 19, ProtoType::UINT32 },
+    { "tls_full_ms", 20, ProtoType::UINT32 },
+    { "tls_resumed_ms", 21, ProtoType::UINT32 },
+    { "tls_resumed", 22, ProtoType::BOOL },
+    { "tls_resume_hits", 23, ProtoType::UINT32 },
+    { "tls_resume_attempts", 24, ProtoType::UINT32 },
+    { "tls_failures", 25, ProtoType::UINT32 },
+    { "tls_resume_rate", 26, ProtoType::FLOAT },
+    { "wifi_connect_ms", 27, ProtoType::UINT32 },
+    { "wifi_fast", 28, ProtoType::BOOL },
+};
+#endif
+
+// Derleyici sabit değerlerle kodlamayı döngü dışına taşımasın
+static volatile uint8_t relayStates;
+static volatile int rssi = -67;
+static volatile uint32_t freeHeap = 213456;
+static volatile size_t sink;
+
+static char jsonBuf[JSON_BUFFER_SIZE];
+static uint8_t protoBuf[JSON_BUFFER_SIZE];
+
+// RelayController::writeStatesJson / writeStatesProto
+static size_t relaysJson(uint8_t mask) {
+    JsonWriter json(jsonBuf, sizeof(jsonBuf));
+    uint8_t states = relayStates;
+    char key[8];
+    json.beginObject();
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (!(mask & (1 << i))) continue;
+        snprintf(key, sizeof(key), "relay%d", i + 1);
+        json.add(key, (bool)((states >> i) & 1));
+    }
+    json.endObject();
+    return json.length();
+}
+
+static size_t relaysProto(uint8_t mask) {
+    ProtoWriter proto(protoBuf, sizeof(protoBuf));
+    uint8_t states = relayStates;
+    for (int i = 0; i < RELAY_COUNT; i++) {
+        if (!(mask & (1 << i))) continue;
+        proto.addBool(i + 1, (states >> i) & 1);
+    }
+    return proto.length();
+}
+
+// ThingsBoardMQTT::updateDynamicAttributes
+static size_t attrsJson() {
+    JsonWriter json(jsonBuf, sizeof(jsonBuf));
+    json.beginObject();
+    json.add("rssi", (int)rssi);
+    json.add("free_heap", (uint32_t)freeHeap);
+    json.endObject();
+    return json.length();
+}
+
+static size_t attrsProto() {
+    ProtoWriter proto(protoBuf, sizeof(protoBuf));
+    proto.addSInt(7, rssi);
+    proto.addUInt(8, freeHeap);
+    return proto.length();
+}
+
+#ifndef HOST_ARDUINOJSON_STUB
+// Cihazdaki yol: JSON yazılır, ThingsBoardMQTT::enqueue çözüp şemaya göre çevirir
+static size_t attrsTranscode() {
+    size_t jsonLen = attrsJson();
+    StaticJsonDocument<PROTO_TRANSCODE_CAPACITY> doc;
+    if (deserializeJson(doc, jsonBuf, jsonLen)) return 0;
+    ProtoWriter proto(protoBuf, sizeof(protoBuf));
+    if (!proto.addJson(doc.as<JsonObjectConst>(), PROTO_SCHEMA, sizeof(PROTO_SCHEMA) / sizeof(PROTO_SCHEMA[0]))) {
+        return 0;
+    }
+    return proto.length();
+}
+#endif
+
+template <typename F>
+static double nsPerMessage(F encode, long iterations) {
+    using namespace std::chrono;
+    size_t total = 0;
+    steady_clock::time_point start = steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        total += encode();
+    }
+    double ns = duration<double, std::nano>(steady_clock::now() - start).count();
+    sink = total;
+    return ns / iterations;
+}
+
+static void row(const char* name, size_t jsonBytes, size_t protoBytes,
+                double jsonNs, double protoNs, double deviceNs) {
+    char device[24];
+    if (deviceNs < 0) {
+        snprintf(device, sizeof(device), "n/a");
+    } else {
+        snprintf(device, sizeof(device), "%.0f ns", deviceNs);
+    }
+    printf("| %s | %zu | %zu | %.0f ns | %.0f ns | %s |\n",
+           name, jsonBytes, protoBytes, jsonNs, protoNs, device);
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 1000000;
+    
+    printf("%ld iterations per message, payload bytes only (no MQTT header / topic)\n\n", iterations);
+    printf("| Message | JSON | Protobuf | JSON encode | Protobuf encode | Protobuf, device path |\n");
+    printf("|---------|------|----------|-------------|-----------------|-----------------------|\n");
+    
+    // Relay telemetry cihazda da doğrudan protobuf yazılır
+    relayStates = 0;    // Tüm röleler kapalı
+    double jsonNs = nsPerMessage([] { return relaysJson(RELAY_ALL_MASK); }, iterations);
+    double protoNs = nsPerMessage([] { return relaysProto(RELAY_ALL_MASK); }, iterations);
+    row("Full relay telemetry (all off)", relaysJson(RELAY_ALL_MASK), relaysProto(RELAY_ALL_MASK),
+        jsonNs, protoNs, protoNs);
+    
+    relayStates = 1 << 2;   // relay3 açıldı
+    jsonNs = nsPerMessage([] { return relaysJson(1 << 2); }, iterations);
+    protoNs = nsPerMessage([] { return relaysProto(1 << 2); }, iterations);
+    row("One relay changed", relaysJson(1 << 2), relaysProto(1 << 2), jsonNs, protoNs, protoNs);
+    
+    jsonNs = nsPerMessage(attrsJson, iterations);
+    protoNs = nsPerMessage(attrsProto, iterations);
+#ifndef HOST_ARDUINOJSON_STUB
+    double deviceNs = nsPerMessage(attrsTranscode, iterations);
+    if (attrsTranscode() != attrsProto()) {
+        fprintf(stderr, "Transcoded size differs from direct encoding\n");
+        return 1;
+    }
+#else
+    double deviceNs = -1;   // ArduinoJson yok: JSON -> protobuf çevirisi ölçülmedi
+#endif
+    row("`rssi` + `free_heap` update", attrsJson(), attrsProto(), jsonNs, protoNs, deviceNs);
+    
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host derlemesi için Arduino çekirdeğinin kullanılan kısmı (tools/host).
+// Serial çıktısı stderr'e gider; stdout test / benchmark sonuçlarına kalır.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+
+class HostSerial {
+public:
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int n = vfprintf(stderr, format, args);
+        va_end(args);
+        return n < 0 ? 0 : n;
+    }
+    size_t print(const char* s) { return fputs(s, stderr) < 0 ? 0 : strlen(s); }
+    size_t println(const char* s = "") { return print(s) + print("\n"); }
+};
+
+extern HostSerial Serial;
+
+inline unsigned long millis() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+template<class T> T min(T a, T b) { return a < b ? a : b; }
+template<class T> T max(T a, T b) { return a > b ? a : b; }
+
+#endif // HOST_ARDUINO_H
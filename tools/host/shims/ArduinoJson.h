@@ -0,0 +1,31 @@
+#ifndef HOST_ARDUINOJSON_H
+#define HOST_ARDUINOJSON_H
+
+// ArduinoJson verilmediğinde ProtoWriter::addJson'un derlenmesi için boş tipler.
+// Gerçek kütüphane: cmake -DARDUINOJSON_DIR=<ArduinoJson>/src (v6)
+#define HOST_ARDUINOJSON_STUB 1
+
+class JsonString {
+public:
+    const char* c_str() const { return ""; }
+};
+
+class JsonVariantConst {
+public:
+    template <typename T> bool is() const { return false; }
+    template <typename T> T as() const { return T(); }
+};
+
+class JsonPairConst {
+public:
+    JsonString key() const { return JsonString(); }
+    JsonVariantConst value() const { return JsonVariantConst(); }
+};
+
+class JsonObjectConst {
+public:
+    const JsonPairConst* begin() const { return nullptr; }
+    const JsonPairConst* end() const { return nullptr; }
+};
+
+#endif // HOST_ARDUINOJSON_H
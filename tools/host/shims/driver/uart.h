@@ -0,0 +1,67 @@
+#ifndef HOST_DRIVER_UART_H
+#define HOST_DRIVER_UART_H
+
+// ESP-IDF UART sürücüsünün Modbus'ta kullanılan kısmı. host_uart.cpp bunu
+// bir seri porta / pty'ye bağlar: gelen baytlar RX timeout'lu UART_DATA olayına
+// çevrilir (3.5 karakter sessizlik yerine HOST_UART_GAP_MS).
+
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef int esp_err_t;
+#define ESP_OK      0
+#define ESP_FAIL    -1
+
+typedef int uart_port_t;
+
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0, UART_PARITY_EVEN = 2 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_DEFAULT = 0 } uart_sclk_t;
+typedef enum { UART_MODE_UART = 0, UART_MODE_RS485_HALF_DUPLEX = 1 } uart_mode_t;
+
+#define UART_PIN_NO_CHANGE  -1
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uart_sclk_t source_clk;
+} uart_config_t;
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+esp_err_t uart_driver_install(uart_port_t port, int rxSize, int txSize, int queueSize,
+                              QueueHandle_t* queue, int flags);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* cfg);
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts);
+esp_err_t uart_set_mode(uart_port_t port, uart_mode_t mode);
+esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t symbols);
+esp_err_t uart_set_tx_idle_num(uart_port_t port, uint16_t bits);
+esp_err_t uart_flush_input(uart_port_t port);
+int uart_write_bytes(uart_port_t port, const void* data, size_t len);
+int uart_read_bytes(uart_port_t port, void* buf, uint32_t len, TickType_t wait);
+const char* esp_err_to_name(esp_err_t err);
+
+// Host: Modbus UART'ını seri porta / pty'ye bağlar (raw); false: açılamadı
+bool hostUartOpen(const char* path);
+
+#endif // HOST_DRIVER_UART_H
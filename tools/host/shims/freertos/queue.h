@@ -0,0 +1,12 @@
+#ifndef HOST_FREERTOS_QUEUE_H
+#define HOST_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+// Tek kullanıcı Modbus UART olay kuyruğu: host_uart.cpp seri porttan doldurur
+typedef void* QueueHandle_t;
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+#endif // HOST_FREERTOS_QUEUE_H
@@ -0,0 +1,19 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+TickType_t xTaskGetTickCount();
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period);
+
+// Host'ta task açılmaz - test / benchmark ilgili metodu doğrudan çağırır
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*,
+                                          int, TaskHandle_t* handle, int) {
+    if (handle) *handle = nullptr;
+    return pdFAIL;
+}
+
+#endif // HOST_FREERTOS_TASK_H
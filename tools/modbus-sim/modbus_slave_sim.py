@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# Modbus RTU slave simülatörü - cihazın Modbus master'ı (gateway) için sayaç yerine geçer.
+# Varsayılan register haritası ESP32_TB_Relay.ino'daki SDM120 poll tablosudur.
+#
+#   ./modbus_slave_sim.py --pty                   # host testi: pty açar, yolunu yazar
+#   ./modbus_slave_sim.py /dev/ttyUSB0            # USB-RS485 adaptörüyle gerçek hatta
+#   ./modbus_slave_sim.py /dev/ttyUSB0 --silent   # yanıt vermez (zaman aşımı testi)
+#
+# Gerçek seri port için pyserial gerekir (pip install pyserial); --pty yalnızca stdlib.
+import argparse
+import os
+import select
+import struct
+import sys
+import tty
+
+FC_READ_HOLDING = 0x03
+FC_READ_INPUT = 0x04
+EX_ILLEGAL_FUNCTION = 0x01
+EX_ILLEGAL_ADDRESS = 0x02
+
+# Eastron SDM120 input register'ları: float, yüksek word önce
+SDM120 = {
+    0x0000: 230.1,   # voltage
+    0x0006: 1.25,    # current
+    0x000C: 287.6,   # power
+    0x0046: 50.0,    # frequency
+}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def with_crc(frame):
+    crc = crc16(frame)
+    return frame + bytes([crc & 0xFF, crc >> 8])
+
+
+def float_registers(values):
+    regs = {}
+    for addr, value in values.items():
+        hi, lo = struct.unpack(">HH", struct.pack(">f", value))
+        regs[addr] = hi
+        regs[addr + 1] = lo
+    return regs
+
+
+def reply(frame, slave_id, regs):
+    """İstek çerçevesine yanıt; yanıt verilmeyecekse None."""
+    if len(frame) < 4 or crc16(frame[:-2]) != frame[-2] | (frame[-1] << 8):
+        print("CRC error, ignored: %s" % frame.hex(" "))
+        return None
+    if frame[0] != slave_id:
+        return None
+
+    fc = frame[1]
+    if fc not in (FC_READ_HOLDING, FC_READ_INPUT) or len(frame) != 8:
+        return with_crc(bytes([slave_id, fc | 0x80, EX_ILLEGAL_FUNCTION]))
+
+    start, count = struct.unpack(">HH", frame[2:6])
+    if count < 1 or count > 125:
+        return with_crc(bytes([slave_id, fc | 0x80, EX_ILLEGAL_ADDRESS]))
+
+    # Haritada olmayan register'lar 0 okunur (sayaçlardaki boşluklar gibi)
+    data = b"".join(struct.pack(">H", regs.get(start + i, 0)) for i in range(count))
+    return with_crc(bytes([slave_id, fc, len(data)]) + data)
+
+
+class PtyPort:
+    def __init__(self):
+        self.fd, slave = os.openpty()
+        tty.setraw(slave)
+        tty.setraw(self.fd)
+        self.name = os.ttyname(slave)
+        self._slave = slave     # Açık kalmalı, yoksa master tarafı EIO verir
+
+    def read(self, timeout):
+        if not select.select([self.fd], [], [], timeout)[0]:
+            return b""
+        try:
+            return os.read(self.fd, 256)
+        except OSError:
+            return b""
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+
+class SerialPort:
+    def __init__(self, device, baud, parity):
+        import serial
+        self._port = serial.Serial(device, baud, bytesize=8, stopbits=1,
+                                   parity=serial.PARITY_EVEN if parity else serial.PARITY_NONE)
+        self.name = device
+
+    def read(self, timeout):
+        self._port.timeout = timeout
+        first = self._port.read(1)
+        return first + self._port.read(self._port.in_waiting) if first else b""
+
+    def write(self, data):
+        self._port.write(data)
+        self._port.flush()
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Modbus RTU slave simulator")
+    ap.add_argument("port", nargs="?", help="serial device (USB-RS485 adapter)")
+    ap.add_argument("--pty", action="store_true", help="create a pseudo terminal instead")
+    ap.add_argument("--slave", type=int, default=1, help="slave address (default 1)")
+    ap.add_argument("--baud", type=int, default=9600, help="MODBUS_BAUD (default 9600)")
+    ap.add_argument("--even", action="store_true", help="8E1 (MODBUS_PARITY_EVEN)")
+    ap.add_argument("--silent", action="store_true", help="never reply")
+    args = ap.parse_args()
+
+    if args.pty == bool(args.port):
+        ap.error("give a serial port or --pty")
+
+    sys.stdout.reconfigure(line_buffering=True)
+    port = PtyPort() if args.pty else SerialPort(args.port, args.baud, args.even)
+    regs = float_registers(SDM120)
+    # Çerçeve sonu: 3.5 karakter sessizlik (11 bit/karakter), en az 5 ms
+    gap = max(0.005, 3.5 * 11 / args.baud)
+
+    print("Modbus slave %d on %s" % (args.slave, port.name))
+
+    frame = b""
+    while True:
+        chunk = port.read(gap if frame else None)
+        if chunk:
+            frame += chunk
+            continue
+        if not frame:
+            continue
+
+        response = None if args.silent else reply(frame, args.slave, regs)
+        print("<- %s" % frame.hex(" "))
+        frame = b""
+        if response is not None:
+            port.write(response)
+            print("-> %s" % response.hex(" "))
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        sys.exit(0)
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Yerel TLS broker için test CA'sı ve sunucu sertifikası üretir.
+# Kullanım: ./gen-certs.sh <broker-hostname> [broker-ip]
+#   ./gen-certs.sh tb-test.local 192.168.1.50
+set -e
+
+HOST="${1:?usage: $0 <broker-hostname> [broker-ip]}"
+IP="$2"
+DIR="$(cd "$(dirname "$0")" && pwd)/certs"
+DAYS=825
+
+mkdir -p "$DIR"
+cd "$DIR"
+
+SAN="DNS:$HOST"
+[ -n "$IP" ] && SAN="$SAN,IP:$IP"
+
+# CA (portaldaki "CA Sertifikasi" alanına ca.crt yapıştırılır)
+openssl ecparam -name prime256v1 -genkey -noout -out ca.key
+openssl req -x509 -new -key ca.key -sha256 -days "$DAYS" -subj "/CN=ESP32 Relay Test CA" -out ca.crt
+
+# Sunucu - cihaz portalda girilen sunucu adını sertifikayla doğrular
+openssl ecparam -name prime256v1 -genkey -noout -out server.key
+openssl req -new -key server.key -subj "/CN=$HOST" -out server.csr
+printf "subjectAltName=%s\nextendedKeyUsage=serverAuth\n" "$SAN" > server.ext
+openssl x509 -req -in server.csr -CA ca.crt -CAkey ca.key -CAcreateserial \
+    -sha256 -days "$DAYS" -extfile server.ext -out server.crt
+rm -f server.csr server.ext ca.srl
+
+echo "Certificates in $DIR (SAN: $SAN)"
+echo "Paste $DIR/ca.crt into the portal's CA field."